@@ -1,21 +1,102 @@
 #include "filesys/buffer_cache.h"
+#include <stdlib.h>
+#include <string.h>
 #include "filesys/filesys.h"
+#include "devices/timer.h"
 
 #define NUM_CACHE 64
 
+/* write-behind thread가 깨어나 dirty entry 수를 확인하는 주기 (tick) */
+#define WRITE_BEHIND_POLL (TIMER_FREQ / 10)
+
+/* write-behind 설정 (kernel command line "-wb-interval", "-wb-dirty"로 변경 가능)
+   interval tick마다, 또는 dirty entry 수가 dirty_max 이상이 되면 dirty entry를 disk에 write */
+int buffer_cache_flush_interval = TIMER_FREQ;
+int buffer_cache_dirty_max = NUM_CACHE / 4;
+
 static int check_idx;	// for sec chance algoritm
 static struct buffer_cache_entry cache[NUM_CACHE];
+static uint8_t cache_data[NUM_CACHE][BLOCK_SECTOR_SIZE];	// 각 entry의 sector data
+
+static struct hash cache_hash;	// disk sector -> buffer cache entry
+static struct list free_list;	// 사용하지 않는 (invalid) buffer cache entry list
+static struct condition buffer_cache_unpinned;	// pin이 풀린 entry가 생길 때 signal
+static struct condition buffer_cache_filled;	// disk에서 읽기가 끝난 entry가 생길 때 broadcast
+
+static struct buffer_cache_entry *buffer_cache_get (block_sector_t sector, bool zero);
+static void buffer_cache_unpin (struct buffer_cache_entry *bce);
+static void write_behind (void *aux);
+
+static unsigned cache_hash_func (const struct hash_elem *e, void *aux UNUSED)
+{
+  /* disk sector 번호에 대한 해시값 return */
+  return hash_int (hash_entry (e, struct buffer_cache_entry, hash_elem)->disk_sector);
+}
+
+static bool cache_less_func (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+  struct buffer_cache_entry *bcea = hash_entry (a, struct buffer_cache_entry, hash_elem);
+  struct buffer_cache_entry *bceb = hash_entry (b, struct buffer_cache_entry, hash_elem);
+
+  return bcea->disk_sector < bceb->disk_sector;
+}
 
 /* buffer cache initialization */
 void buffer_cache_init (void)
 {
   /* sec chance idx */
   check_idx = 0; 
-  /* 각 buffer invalid로 init */
-  for(int i=0; i<NUM_CACHE; i++)
+  hash_init (&cache_hash, cache_hash_func, cache_less_func, NULL);
+  list_init (&free_list);
+  /* 각 buffer invalid로 init하고 free list에 삽입 */
+  for(int i=0; i<NUM_CACHE; i++){
     cache[i].valid_bit = false;
+    cache[i].io_busy = false;
+    cache[i].pin_cnt = 0;
+    cache[i].buffer = cache_data[i];
+    rw_lock_init (&cache[i].rw);
+    list_push_back (&free_list, &cache[i].free_elem);
+  }
   /* lock init */
   lock_init(&buffer_cache_lock);
+  cond_init(&buffer_cache_unpinned);
+  cond_init(&buffer_cache_filled);
+
+  /* write-behind thread 생성 */
+  thread_create ("write-behind", PRI_DEFAULT, write_behind, NULL);
+}
+
+/* 주기적으로, 또는 dirty entry가 많아지면 dirty entry를 disk에 write하는 kernel thread
+   eviction 시 victim이 대부분 clean하도록 하여 foreground의 write back 비용을 줄임 */
+static void write_behind (void *aux UNUSED)
+{
+  int64_t last_flush = timer_ticks ();
+
+  for (;;) {
+    int poll = buffer_cache_flush_interval < WRITE_BEHIND_POLL
+               ? buffer_cache_flush_interval : WRITE_BEHIND_POLL;
+    timer_sleep (poll > 0 ? poll : 1);
+
+    if (timer_elapsed (last_flush) >= buffer_cache_flush_interval
+        || buffer_cache_dirty_cnt () >= buffer_cache_dirty_max) {
+      buffer_cache_flush_all ();
+      last_flush = timer_ticks ();
+    }
+  }
+}
+
+/* dirty entry 수 return */
+int buffer_cache_dirty_cnt (void)
+{
+  int cnt = 0;
+
+  lock_acquire(&buffer_cache_lock);
+  for(int i=0; i < NUM_CACHE; i++)
+    if(cache[i].valid_bit && cache[i].dirty_bit)
+      cnt++;
+  lock_release(&buffer_cache_lock);
+
+  return cnt;
 }
 
 /* 모든 buffer flush */
@@ -27,121 +108,283 @@ void buffer_cache_terminate (void)
 /* read from buffer cache */
 void buffer_cache_read (block_sector_t sector, uint8_t *buffer, int chunk_size, off_t bytes_read, int sector_ofs)
 {
-  lock_acquire(&buffer_cache_lock);
-  /* buffer entry 찾기 */
+  /* buffer entry 찾기 (pin된 상태로 return) */
   struct buffer_cache_entry *bce = find_buffer_cache (sector);
-  bce->reference_bit = true;	// reference bit 갱신
+
+  /* 여러 reader가 동시에 같은 entry read 가능 */
+  rw_lock_acquire_read (&bce->rw);
   memcpy (buffer + bytes_read, bce->buffer + sector_ofs, chunk_size); 
+  rw_lock_release_read (&bce->rw);
 
-  lock_release(&buffer_cache_lock);  
+  buffer_cache_unpin (bce);
 }
 
 /* write to buffer cache */
-void buffer_cache_write (block_sector_t sector, uint8_t *buffer, int chunk_size, off_t bytes_written, int sector_ofs)
+void buffer_cache_write (block_sector_t sector, const uint8_t *buffer, int chunk_size, off_t bytes_written, int sector_ofs)
 {
-  lock_acquire(&buffer_cache_lock);
-  /* buffer entry 찾기 */
+  /* buffer entry 찾기 (pin된 상태로 return) */
   struct buffer_cache_entry *bce = find_buffer_cache (sector);
-  bce->reference_bit = true;	// reference bit 갱신
+
+  /* writer는 entry를 exclusive하게 사용 */
+  rw_lock_acquire_write (&bce->rw);
   bce->dirty_bit = true;        // dirty bit 갱신
   memcpy (bce->buffer + sector_ofs, buffer + bytes_written, chunk_size);
+  rw_lock_release_write (&bce->rw);
 
-  lock_release(&buffer_cache_lock);
+  buffer_cache_unpin (bce);
 }
 
-/* buffer cache 찾아 return하는 함수 */
+/* buffer cache 찾아 return하는 함수
+   return된 entry는 pin되어 있으므로 사용 후 buffer_cache_unpin() 호출해야 함 */
 struct buffer_cache_entry *find_buffer_cache (block_sector_t sector)
 {
-  /* buffer_cache에 sector 존재하는 지 확인 */
-  struct buffer_cache_entry *ret = buffer_cache_lookup (sector);
-  if(ret != NULL)
-    return ret;
+  return buffer_cache_get (sector, false);
+}
+
+/* sector에 해당하는 pin된 entry return
+   cache에 없는 경우 ZERO가 true면 disk read 없이 0으로 채운 dirty entry로 load */
+static struct buffer_cache_entry *buffer_cache_get (block_sector_t sector, bool zero)
+{
+  struct buffer_cache_entry *ret;
+
+  lock_acquire(&buffer_cache_lock);
+  while (1) {
+    /* buffer_cache에 sector 존재하는 지 확인 */
+    ret = buffer_cache_lookup (sector);
+    if(ret != NULL){
+      /* 다른 thread가 disk에서 읽는 중이라면 읽기가 끝날 때까지 대기한 뒤 다시 탐색
+         (다른 sector에 대한 hit는 대기 없이 계속 처리됨) */
+      if(ret->io_busy){
+        cond_wait (&buffer_cache_filled, &buffer_cache_lock);
+        continue;
+      }
+      ret->pin_cnt++;
+      ret->reference_bit = true;	// reference bit 갱신
+      lock_release(&buffer_cache_lock);
+      return ret;
+    }
 
-  /* buffer cache에 없는 경우, empty buffer cache 확인 */
-  ret = find_empty_buffer (sector);
-  /* empty buffer 없는 경우, sec chance algoritm으로 buffer cache entry evict */
-  if(ret == NULL)
-    ret = buffer_cache_select_victim (sector);
+    /* buffer cache에 없는 경우, empty buffer cache 확인 */
+    ret = find_empty_buffer (sector);
+    /* empty buffer 없는 경우, sec chance algoritm으로 buffer cache entry evict */
+    if(ret == NULL)
+      ret = buffer_cache_select_victim (sector);
+    /* victim을 얻지 못했다면 (dirty victim write back, 또는 모든 entry가 사용 중)
+       buffer_cache_lock이 잠시 release 되었으므로 처음부터 다시 탐색 */
+    if(ret != NULL)
+      break;
+  }
+  lock_release(&buffer_cache_lock);
 
-  /* buffer cache에 block sector 저장 */
-  block_read (fs_device, sector, ret->buffer);
+  /* buffer cache에 block sector 저장
+     buffer_cache_lock 없이 I/O 하므로 다른 entry에 대한 hit는 계속 처리됨 */
+  if(zero){
+    memset (ret->buffer, 0, BLOCK_SECTOR_SIZE);
+    ret->dirty_bit = true;
+  }
+  else
+    block_read (fs_device, sector, ret->buffer);
+
+  rw_lock_release_write (&ret->rw);
+  /* 읽기를 기다리던 thread 깨우기 (entry는 아직 pin되어 있으므로 evict되지 않음) */
+  lock_acquire(&buffer_cache_lock);
+  ret->io_busy = false;
+  cond_broadcast (&buffer_cache_filled, &buffer_cache_lock);
+  lock_release(&buffer_cache_lock);
   return ret;
 }
 
+/* 새로 할당된 sector를 buffer cache에서 0으로 채움
+   disk에서 읽지 않으며, disk에는 evict 또는 flush 시에 한 번만 write됨 */
+void buffer_cache_zero (block_sector_t sector)
+{
+  struct buffer_cache_entry *bce = buffer_cache_get (sector, true);
+
+  /* 이미 cache에 있던 entry (이전에 free된 block의 data)일 수 있으므로 다시 0으로 채움 */
+  rw_lock_acquire_write (&bce->rw);
+  memset (bce->buffer, 0, BLOCK_SECTOR_SIZE);
+  bce->dirty_bit = true;
+  rw_lock_release_write (&bce->rw);
+  buffer_cache_unpin (bce);
+}
+
+/* read-ahead: sector를 미리 buffer cache에 load (data copy 없음)
+   이미 cache에 있거나 다른 thread가 읽는 중 (io_busy)이라면 아무것도 하지 않음 */
+void buffer_cache_prefetch (block_sector_t sector)
+{
+  bool cached;
+
+  lock_acquire(&buffer_cache_lock);
+  cached = buffer_cache_lookup (sector) != NULL;
+  lock_release(&buffer_cache_lock);
+
+  if(!cached)
+    buffer_cache_unpin (find_buffer_cache (sector));
+}
+
 /* buffer에 sector에 해당하는 buffer_cache 존재하는 지 확인 */
 struct buffer_cache_entry *buffer_cache_lookup (block_sector_t sector)
 {
-  /* buffer cache table 탐색 */
-  for(int i=0; i < NUM_CACHE; i++){
-    /* block sector가 buffer cache에 있는 경우, 해당 buffer cache entry return */
-    if(cache[i].disk_sector == sector && cache[i].valid_bit)
-      return &cache[i];
-  }
+  struct buffer_cache_entry bce;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&buffer_cache_lock));
+
+  /* hash table에서 sector 탐색 */
+  bce.disk_sector = sector;
+  e = hash_find (&cache_hash, &bce.hash_elem);
+  /* block sector가 buffer cache에 있는 경우, 해당 buffer cache entry return */
+  if(e != NULL)
+    return hash_entry (e, struct buffer_cache_entry, hash_elem);
 
   return NULL;
 }
 
+/* entry에 "sector"를 mapping하고, disk read 진행 중 상태로 설정
+   I/O가 끝날 때까지 다른 thread가 접근하지 못하도록 write lock 획득
+   (pin_cnt가 0이었던 entry이므로 대기 없이 획득됨) */
+static void buffer_cache_claim (struct buffer_cache_entry *bce, block_sector_t sector)
+{
+  ASSERT (bce->pin_cnt == 0);
+
+  bce->valid_bit = true;
+  bce->reference_bit = true;
+  bce->dirty_bit = false;
+  bce->io_busy = true;
+  bce->pin_cnt = 1;
+  bce->disk_sector = sector;
+  hash_insert (&cache_hash, &bce->hash_elem);
+  rw_lock_acquire_write (&bce->rw);
+}
+
 /* empty buffer 찾아 return */
 struct buffer_cache_entry *find_empty_buffer (block_sector_t sector)
 {
-  for(int i=0; i < NUM_CACHE; i++){
-    /* empty cache */
-    if(cache[i].valid_bit == false){
-      cache[i].valid_bit = true;
-      cache[i].reference_bit = true;
-      cache[i].dirty_bit = false;
-      cache[i].disk_sector = sector;
-      return &cache[i];
-    }
-  }
+  /* empty cache 없는 경우 */
+  if(list_empty (&free_list))
+    return NULL;
 
-  return NULL;
+  struct buffer_cache_entry *bce = list_entry (list_pop_front (&free_list),
+                                               struct buffer_cache_entry, free_elem);
+  buffer_cache_claim (bce, sector);
+  return bce;
 }
 
-/* sec chance algorithm으로 buffer cache entry evict */
+/* sec chance algorithm으로 buffer cache entry evict
+   victim이 dirty한 경우 buffer_cache_lock을 release하고 write back한 뒤 NULL return
+   (그 동안에도 victim의 기존 sector에 대한 hit는 처리됨)
+   pin되지 않은 entry가 없는 경우 unpin될 때까지 대기한 뒤 NULL return */
 struct buffer_cache_entry *buffer_cache_select_victim (block_sector_t sector)
 {
-  struct buffer_cache_entry *evict_buffer;
-  while (1) {
-    /* reference bit가 false면 해당 buffer cache entry evict */
-    if(cache[check_idx].reference_bit == false){
-      evict_buffer = &cache[check_idx];
-      break;
-    }
+  struct buffer_cache_entry *evict_buffer = NULL;
+
+  /* 모든 entry를 두 바퀴 확인하면 reference bit와 관계없이 victim 결정됨 */
+  for (int i = 0; i < 2 * NUM_CACHE; i++) {
+    struct buffer_cache_entry *bce = &cache[check_idx];
+    check_idx = (check_idx + 1) % NUM_CACHE;
+
+    /* 사용 중 (I/O 진행 중 포함) 인 entry는 evict하지 않음 */
+    if(bce->pin_cnt > 0)
+      continue;
     /* reference bit가 true면 
        해당 buffer cache entry의 reference bit false로 변경하고
        다음 buffer cache entry 확인 */
-    cache[check_idx].reference_bit = false;
-    check_idx = (check_idx + 1) % NUM_CACHE;
+    if(bce->reference_bit){
+      bce->reference_bit = false;
+      continue;
+    }
+    /* reference bit가 false면 해당 buffer cache entry evict */
+    evict_buffer = bce;
+    break;
+  }
+
+  /* 모든 entry가 사용 중인 경우 */
+  if(evict_buffer == NULL){
+    cond_wait (&buffer_cache_unpinned, &buffer_cache_lock);
+    return NULL;
   }
   
   /* evict하는 buffer cache entry의 dirty bit가 true면 disk에 write */
-  if(evict_buffer->dirty_bit)
+  if(evict_buffer->dirty_bit){
+    evict_buffer->pin_cnt++;
+    lock_release(&buffer_cache_lock);
+
+    /* write back 중에도 reader는 entry 접근 가능 */
+    rw_lock_acquire_read (&evict_buffer->rw);
     buffer_cache_flush_entry(evict_buffer);
+    rw_lock_release_read (&evict_buffer->rw);
+
+    lock_acquire(&buffer_cache_lock);
+    evict_buffer->pin_cnt--;
+    if(evict_buffer->pin_cnt == 0)
+      cond_signal (&buffer_cache_unpinned, &buffer_cache_lock);
+    return NULL;
+  }
 
   /* evict한 buffer cache entry에 "sector" 저장 */
-  evict_buffer->valid_bit = true;
-  evict_buffer->dirty_bit = false;
-  evict_buffer->disk_sector = sector;
-  check_idx = (check_idx + 1) % NUM_CACHE;
+  hash_delete (&cache_hash, &evict_buffer->hash_elem);
+  buffer_cache_claim (evict_buffer, sector);
   return evict_buffer;
 }
 
-/* buffer cache entry disk에 write */
+/* find_buffer_cache()로 얻은 entry 사용 완료 */
+static void buffer_cache_unpin (struct buffer_cache_entry *bce)
+{
+  lock_acquire(&buffer_cache_lock);
+  ASSERT (bce->pin_cnt > 0);
+  bce->pin_cnt--;
+  if(bce->pin_cnt == 0)
+    cond_signal (&buffer_cache_unpinned, &buffer_cache_lock);
+  lock_release(&buffer_cache_lock);
+}
+
+/* buffer cache entry disk에 write
+   writer가 없도록 entry의 rw lock을 (shared로) 잡은 상태에서 호출 */
 void buffer_cache_flush_entry(struct buffer_cache_entry* bce)
 {
   block_write (fs_device, bce->disk_sector, bce->buffer);
   bce->dirty_bit = false; 
 }
 
-/* 모든 buffer cache entry의 dirty bit check하여 disk에 write */
+/* disk sector 순서 비교 (qsort) */
+static int compare_sector (const void *a_, const void *b_)
+{
+  const struct buffer_cache_entry *a = *(struct buffer_cache_entry * const *) a_;
+  const struct buffer_cache_entry *b = *(struct buffer_cache_entry * const *) b_;
+
+  if (a->disk_sector < b->disk_sector)
+    return -1;
+  return a->disk_sector > b->disk_sector;
+}
+
+/* 모든 buffer cache entry의 dirty bit check하여 disk에 write
+   disk head 이동을 줄이기 위해 sector 순서로 write */
 void buffer_cache_flush_all(void)
 {
-  /* 모든 buffer cache flush */
+  struct buffer_cache_entry *dirty[NUM_CACHE];
+  int dirty_cnt = 0;
+
+  /* valid하면서 dirty bit가 true인 entry를 pin하여 모음 */
+  lock_acquire(&buffer_cache_lock);
   for(int i=0; i < NUM_CACHE; i++){
-    /* valid하면서 dirty bit가 true인 entry disk에 write */
-    if(cache[i].valid_bit && cache[i].dirty_bit)
-      buffer_cache_flush_entry(&cache[i]);
+    if(cache[i].valid_bit && cache[i].dirty_bit){
+      cache[i].pin_cnt++;
+      dirty[dirty_cnt++] = &cache[i];
+    }
   }
-}
+  lock_release(&buffer_cache_lock);
+
+  qsort (dirty, dirty_cnt, sizeof *dirty, compare_sector);
+
+  /* sector 순서로 disk에 write */
+  for(int i=0; i < dirty_cnt; i++){
+    struct buffer_cache_entry *bce = dirty[i];
 
+    rw_lock_acquire_read (&bce->rw);
+    if(bce->dirty_bit)
+      buffer_cache_flush_entry(bce);
+    rw_lock_release_read (&bce->rw);
+
+    buffer_cache_unpin (bce);
+  }
+}
@@ -1,7 +1,10 @@
 #ifndef FILESYS_BUFFER_CACHE_H
 #define FILESYS_BUFFER_CACHE_H
 
+#include <hash.h>
+#include <list.h>
 #include "threads/thread.h"
+#include "threads/synch.h"
 #include "devices/block.h"
 #include "filesys/off_t.h"
 #include "lib/stdbool.h"
@@ -10,21 +13,33 @@ struct buffer_cache_entry{
   bool valid_bit;	// valid entry ?
   bool reference_bit;	// referenced ?
   bool dirty_bit;	// modified ? 
+  bool io_busy;		// disk에서 읽는 중 ? (lookup은 읽기가 끝날 때까지 대기)
+  int pin_cnt;		// entry를 사용 중인 thread 수, 0인 경우에만 evict 가능
+  struct rw_lock rw;	// data 접근 lock (reader는 shared, writer는 exclusive)
   block_sector_t disk_sector;
-  uint8_t buffer[BLOCK_SECTOR_SIZE];	// 512 * 1B
+  struct hash_elem hash_elem;	// sector 번호로 entry 탐색하기 위한 hash_elem
+  struct list_elem free_elem;	// free list에서 관리하기 위한 list_elem
+  uint8_t *buffer;	// BLOCK_SECTOR_SIZE (512B) data
 };
 
-struct lock buffer_cache_lock;
+struct lock buffer_cache_lock;	// hash, free list, pin_cnt 등 entry 관리 정보 보호
+
+/* write-behind 설정 */
+extern int buffer_cache_flush_interval;	// write-behind 주기 (tick)
+extern int buffer_cache_dirty_max;	// dirty entry 수 high-water mark
 
 void buffer_cache_init (void);
 void buffer_cache_terminate (void);
 void buffer_cache_read (block_sector_t sector, uint8_t *buffer, int chunk_size, off_t bytes_read, int sector_ofs);
-void buffer_cache_write (block_sector_t sector, uint8_t *buffer, int chunk_size, off_t bytes_written, int sector_ofs);
+void buffer_cache_write (block_sector_t sector, const uint8_t *buffer, int chunk_size, off_t bytes_written, int sector_ofs);
+void buffer_cache_prefetch (block_sector_t sector);
+void buffer_cache_zero (block_sector_t sector);
 struct buffer_cache_entry *find_buffer_cache (block_sector_t sector);
 struct buffer_cache_entry *buffer_cache_lookup (block_sector_t sector);
 struct buffer_cache_entry *find_empty_buffer (block_sector_t sector);
 struct buffer_cache_entry *buffer_cache_select_victim (block_sector_t sector);
 void buffer_cache_flush_entry(struct buffer_cache_entry* bce);
 void buffer_cache_flush_all(void);
+int buffer_cache_dirty_cnt (void);
 
 #endif
@@ -0,0 +1,170 @@
+#include "filesys/dcache.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <string.h>
+#include "threads/synch.h"
+
+#define NUM_DCACHE 256
+
+struct dcache_entry{
+  block_sector_t parent;	// parent directory inode sector
+  char name[NAME_MAX + 1];	// entry name
+  block_sector_t sector;	// child inode sector, 0: negative entry
+  struct hash_elem hash_elem;	// (parent, name)으로 entry 탐색하기 위한 hash_elem
+  struct list_elem lru_elem;	// LRU list element (사용하지 않는 entry는 free list)
+};
+
+static struct dcache_entry dcache[NUM_DCACHE];
+static struct hash dcache_hash;	// (parent, name) -> dcache entry
+static struct list lru_list;	// 사용 중인 entry, 최근에 사용한 entry가 앞
+static struct list free_list;	// 사용하지 않는 entry
+static struct lock dcache_lock;	// hash, list, entry, generation 보호
+static unsigned dcache_gen;	// directory가 변경될 때마다 증가 (dcache_fill이 오래된 탐색 결과를 기록하지 않도록)
+
+static unsigned dcache_hash_func (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct dcache_entry *de = hash_entry (e, struct dcache_entry, hash_elem);
+  return hash_string (de->name) ^ hash_int (de->parent);
+}
+
+static bool dcache_less_func (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+  const struct dcache_entry *dea = hash_entry (a, struct dcache_entry, hash_elem);
+  const struct dcache_entry *deb = hash_entry (b, struct dcache_entry, hash_elem);
+
+  if (dea->parent != deb->parent)
+    return dea->parent < deb->parent;
+  return strcmp (dea->name, deb->name) < 0;
+}
+
+/* dcache initialization */
+void dcache_init (void)
+{
+  hash_init (&dcache_hash, dcache_hash_func, dcache_less_func, NULL);
+  list_init (&lru_list);
+  list_init (&free_list);
+  for (int i = 0; i < NUM_DCACHE; i++)
+    list_push_back (&free_list, &dcache[i].lru_elem);
+  lock_init (&dcache_lock);
+  dcache_gen = 0;
+}
+
+/* (PARENT, NAME) entry return, 없으면 NULL
+   dcache_lock을 잡은 상태에서 호출 */
+static struct dcache_entry *dcache_find (block_sector_t parent, const char *name)
+{
+  struct dcache_entry key;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&dcache_lock));
+
+  key.parent = parent;
+  strlcpy (key.name, name, sizeof key.name);
+  e = hash_find (&dcache_hash, &key.hash_elem);
+  return e != NULL ? hash_entry (e, struct dcache_entry, hash_elem) : NULL;
+}
+
+/* directory PARENT의 NAME이 cache에 있다면 *SECTORP에 child sector 
+   (negative entry인 경우 0)를 저장하고 true return
+   없으면 현재 generation을 *GENP에 저장하고 false return (directory 탐색 후 dcache_fill에 전달) */
+bool dcache_lookup (block_sector_t parent, const char *name, block_sector_t *sectorp,
+                    unsigned *genp)
+{
+  struct dcache_entry *de = NULL;
+
+  lock_acquire (&dcache_lock);
+  if (strlen (name) <= NAME_MAX)
+    de = dcache_find (parent, name);
+  if (de != NULL)
+    {
+      /* LRU 갱신 */
+      list_remove (&de->lru_elem);
+      list_push_front (&lru_list, &de->lru_elem);
+      *sectorp = de->sector;
+    }
+  else
+    *genp = dcache_gen;
+  lock_release (&dcache_lock);
+  return de != NULL;
+}
+
+/* (PARENT, NAME) entry를 SECTOR로 설정
+   빈 entry가 없으면 가장 오래 사용하지 않은 entry를 교체
+   dcache_lock을 잡은 상태에서 호출 */
+static void dcache_store (block_sector_t parent, const char *name, block_sector_t sector)
+{
+  struct dcache_entry *de;
+
+  ASSERT (lock_held_by_current_thread (&dcache_lock));
+
+  de = dcache_find (parent, name);
+  if (de != NULL)
+    list_remove (&de->lru_elem);
+  else
+    {
+      if (!list_empty (&free_list))
+        de = list_entry (list_pop_front (&free_list), struct dcache_entry, lru_elem);
+      else
+        {
+          de = list_entry (list_pop_back (&lru_list), struct dcache_entry, lru_elem);
+          hash_delete (&dcache_hash, &de->hash_elem);
+        }
+      de->parent = parent;
+      strlcpy (de->name, name, sizeof de->name);
+      hash_insert (&dcache_hash, &de->hash_elem);
+    }
+  de->sector = sector;
+  list_push_front (&lru_list, &de->lru_elem);
+}
+
+/* directory PARENT의 NAME이 SECTOR (0: 없음)로 변경되었음을 cache에 기록
+   dir_add, dir_remove가 directory를 변경한 뒤 호출 */
+void dcache_insert (block_sector_t parent, const char *name, block_sector_t sector)
+{
+  if (strlen (name) > NAME_MAX)
+    return;
+
+  lock_acquire (&dcache_lock);
+  dcache_gen++;
+  dcache_store (parent, name, sector);
+  lock_release (&dcache_lock);
+}
+
+/* cache miss 후 directory를 탐색한 결과 SECTOR (0: 없음)를 cache에 기록
+   GEN은 dcache_lookup이 return한 generation으로, 탐색 중에 directory가 변경되었다면
+   결과가 오래되었을 수 있으므로 기록하지 않음
+   이미 entry가 있다면 (다른 thread가 먼저 기록) 덮어쓰지 않음 */
+void dcache_fill (block_sector_t parent, const char *name, block_sector_t sector,
+                  unsigned gen)
+{
+  if (strlen (name) > NAME_MAX)
+    return;
+
+  lock_acquire (&dcache_lock);
+  if (gen == dcache_gen && dcache_find (parent, name) == NULL)
+    dcache_store (parent, name, sector);
+  lock_release (&dcache_lock);
+}
+
+/* directory PARENT 아래의 entry를 모두 cache에서 제거
+   PARENT가 삭제되어 inode sector가 다른 directory에 재사용될 수 있을 때 호출 */
+void dcache_invalidate (block_sector_t parent)
+{
+  struct list_elem *e, *next;
+
+  lock_acquire (&dcache_lock);
+  dcache_gen++;
+  for (e = list_begin (&lru_list); e != list_end (&lru_list); e = next)
+    {
+      struct dcache_entry *de = list_entry (e, struct dcache_entry, lru_elem);
+      next = list_next (e);
+      if (de->parent == parent)
+        {
+          hash_delete (&dcache_hash, &de->hash_elem);
+          list_remove (&de->lru_elem);
+          list_push_back (&free_list, &de->lru_elem);
+        }
+    }
+  lock_release (&dcache_lock);
+}
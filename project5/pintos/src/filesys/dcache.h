@@ -0,0 +1,18 @@
+#ifndef FILESYS_DCACHE_H
+#define FILESYS_DCACHE_H
+
+#include <stdbool.h>
+#include "devices/block.h"
+#include "filesys/directory.h"
+
+/* directory entry cache: (parent directory inode sector, name) -> child inode sector
+   child sector가 0인 entry는 negative entry (해당 name이 directory에 없음) */
+void dcache_init (void);
+bool dcache_lookup (block_sector_t parent, const char *name, block_sector_t *sectorp,
+                    unsigned *genp);
+void dcache_insert (block_sector_t parent, const char *name, block_sector_t sector);
+void dcache_fill (block_sector_t parent, const char *name, block_sector_t sector,
+                  unsigned gen);
+void dcache_invalidate (block_sector_t parent);
+
+#endif
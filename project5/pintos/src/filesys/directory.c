@@ -2,7 +2,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
+#include <hash.h>
 #include "filesys/filesys.h"
+#include "filesys/dcache.h"
 #include "filesys/inode.h"
 #include "threads/thread.h"
 #include "threads/malloc.h"
@@ -23,6 +25,20 @@ struct dir_entry
     bool in_use;                        /* In use or free? */
   };
 
+/* 큰 directory는 name hash로 slot을 찾는 hash index (open addressing) 형식으로 변환
+   index된 directory는 2^bits개의 slot으로 이루어지며, 
+   in_use가 false이고 name이 빈 slot은 사용된 적 없는 slot, 
+   name이 남아 있는 slot은 삭제된 slot (tombstone) */
+#define DIR_INDEX_MIN 32        /* 이 수 이상의 slot이 찬 linear directory는 index로 변환 */
+#define DIR_INDEX_MIN_BITS 7    /* 변환 시 최소 index 크기 (128 slot) */
+#define DIR_PROBE_MAX 16        /* add 시 probe가 이보다 길어지면 index 크기 2배 */
+#define DIR_SCAN_CNT 16         /* linear scan 시 한 번에 read하는 entry 수 */
+
+static bool index_lookup (const struct dir *, const char *name,
+                          struct dir_entry *ep, off_t *ofsp);
+static bool index_insert (struct dir *, const struct dir_entry *, bool limit);
+static bool index_rebuild (struct dir *, int min_bits);
+
 /* Creates a directory with space for ENTRY_CNT entries in the
    given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -99,25 +115,134 @@ static bool
 lookup (const struct dir *dir, const char *name,
         struct dir_entry *ep, off_t *ofsp) 
 {
-  struct dir_entry e;
-  size_t ofs;
+  struct dir_entry es[DIR_SCAN_CNT];
+  size_t ofs, cnt, i;
   
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (e.in_use && !strcmp (name, e.name)) 
-      {
-        if (ep != NULL)
-          *ep = e;
-        if (ofsp != NULL)
-          *ofsp = ofs;
-        return true;
-      }
+  if (inode_dir_index_bits (dir->inode))
+    return index_lookup (dir, name, ep, ofsp);
+
+  /* entry를 DIR_SCAN_CNT개씩 read하여 buffer cache 접근 횟수를 줄임 */
+  for (ofs = 0; (cnt = inode_read_at (dir->inode, es, sizeof es, ofs)
+                       / sizeof *es) > 0;
+       ofs += cnt * sizeof *es) 
+    for (i = 0; i < cnt; i++)
+      if (es[i].in_use && !strcmp (name, es[i].name)) 
+        {
+          if (ep != NULL)
+            *ep = es[i];
+          if (ofsp != NULL)
+            *ofsp = ofs + i * sizeof *es;
+          return true;
+        }
   return false;
 }
 
+/* hash index된 DIR에서 NAME 탐색 (lookup()과 같은 방식으로 결과 return)
+   NAME의 hash slot부터 사용된 적 없는 slot을 만날 때까지 probe */
+static bool
+index_lookup (const struct dir *dir, const char *name,
+              struct dir_entry *ep, off_t *ofsp)
+{
+  size_t mask = ((size_t) 1 << inode_dir_index_bits (dir->inode)) - 1;
+  size_t slot = hash_string (name) & mask;
+  struct dir_entry e;
+
+  for (size_t probe = 0; probe <= mask; probe++, slot = (slot + 1) & mask)
+    {
+      off_t ofs = slot * sizeof e;
+      if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+        break;
+      /* 사용된 적 없는 slot이면 NAME은 없음 */
+      if (!e.in_use && e.name[0] == '\0')
+        break;
+      if (e.in_use && !strcmp (name, e.name))
+        {
+          if (ep != NULL)
+            *ep = e;
+          if (ofsp != NULL)
+            *ofsp = ofs;
+          return true;
+        }
+    }
+  return false;
+}
+
+/* hash index된 DIR에 E를 추가
+   LIMIT가 true면 DIR_PROBE_MAX번 안에 빈 slot을 찾지 못한 경우 false return */
+static bool
+index_insert (struct dir *dir, const struct dir_entry *e, bool limit)
+{
+  size_t mask = ((size_t) 1 << inode_dir_index_bits (dir->inode)) - 1;
+  size_t slot = hash_string (e->name) & mask;
+  struct dir_entry old;
+
+  for (size_t probe = 0; probe <= mask; probe++, slot = (slot + 1) & mask)
+    {
+      off_t ofs = slot * sizeof old;
+      if (limit && probe >= DIR_PROBE_MAX)
+        break;
+      if (inode_read_at (dir->inode, &old, sizeof old, ofs) != sizeof old)
+        break;
+      /* 빈 slot 또는 삭제된 slot에 write */
+      if (!old.in_use)
+        return inode_write_at (dir->inode, e, sizeof *e, ofs) == sizeof *e;
+    }
+  return false;
+}
+
+/* DIR의 모든 entry를 2^MIN_BITS 이상, entry 수의 2배 이상인 크기의 hash index로 다시 배치
+   (linear directory의 index 변환, index 크기 확장에 사용) */
+static bool
+index_rebuild (struct dir *dir, int min_bits)
+{
+  struct dir_entry es[DIR_SCAN_CNT];
+  struct dir_entry *entries;
+  off_t length = inode_length (dir->inode);
+  size_t ofs, cnt, i, entry_cnt = 0;
+  int bits = min_bits;
+  bool success = true;
+
+  /* 사용 중인 entry 수 확인 후 모두 memory로 read */
+  for (ofs = 0; (cnt = inode_read_at (dir->inode, es, sizeof es, ofs)
+                       / sizeof *es) > 0;
+       ofs += cnt * sizeof *es)
+    for (i = 0; i < cnt; i++)
+      if (es[i].in_use)
+        entry_cnt++;
+
+  entries = malloc ((entry_cnt + 1) * sizeof *entries);
+  if (entries == NULL)
+    return false;
+  entry_cnt = 0;
+  for (ofs = 0; (cnt = inode_read_at (dir->inode, es, sizeof es, ofs)
+                       / sizeof *es) > 0;
+       ofs += cnt * sizeof *es)
+    for (i = 0; i < cnt; i++)
+      if (es[i].in_use)
+        entries[entry_cnt++] = es[i];
+
+  /* load factor 1/2 이하 */
+  while (((size_t) 1 << bits) < 2 * (entry_cnt + 1))
+    bits++;
+
+  /* 기존 data를 0으로 덮어쓰고, 늘어나는 부분은 마지막 slot만 write하여 hole로 둠 */
+  memset (es, 0, sizeof es);
+  for (ofs = 0; ofs < (size_t) length; ofs += sizeof es)
+    inode_write_at (dir->inode, es, sizeof es, ofs);
+  ofs = (((size_t) 1 << bits) - 1) * sizeof *es;
+  if (ofs >= (size_t) length)
+    inode_write_at (dir->inode, es, sizeof *es, ofs);
+  inode_set_dir_index_bits (dir->inode, bits);
+
+  for (i = 0; i < entry_cnt && success; i++)
+    success = index_insert (dir, &entries[i], false);
+  free (entries);
+  return success;
+}
+
 /* Searches DIR for a file with the given NAME
    and returns true if one exists, false otherwise.
    On success, sets *INODE to an inode for the file, otherwise to
@@ -142,10 +267,18 @@ dir_lookup (const struct dir *dir, const char *name,
     else 
       *inode = inode_reopen (dir->par->inode);
   }
-  else if (lookup (dir, name, &e, NULL))
-    *inode = inode_open (e.inode_sector);
-  else
-    *inode = NULL;
+  else {
+    /* dcache에 없는 경우에만 directory 탐색, 결과 (없는 경우 포함)는 dcache에 기록
+       탐색 중에 dir_add, dir_remove가 끝났다면 dcache_fill이 결과를 버림 */
+    block_sector_t parent = inode_get_inumber (dir->inode);
+    block_sector_t sector;
+    unsigned gen;
+    if (!dcache_lookup (parent, name, &sector, &gen)) {
+      sector = lookup (dir, name, &e, NULL) ? e.inode_sector : 0;
+      dcache_fill (parent, name, sector, gen);
+    }
+    *inode = sector != 0 ? inode_open (sector) : NULL;
+  }
 
   return *inode != NULL;
 }
@@ -182,6 +315,20 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   }
   inode_close (new_entry);
 
+  memset (&e, 0, sizeof e);
+  e.in_use = true;
+  strlcpy (e.name, name, sizeof e.name);
+  e.inode_sector = inode_sector;
+
+  /* hash index된 directory: probe가 길어지면 index 크기를 2배로 늘린 뒤 다시 시도 */
+  int bits = inode_dir_index_bits (dir->inode);
+  if (bits)
+    {
+      success = index_insert (dir, &e, true)
+                || (index_rebuild (dir, bits + 1) && index_insert (dir, &e, false));
+      goto done;
+    }
+
   /* Set OFS to offset of free slot.
      If there are no free slots, then it will be set to the
      current end-of-file.
@@ -189,18 +336,32 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
      inode_read_at() will only return a short read at end of file.
      Otherwise, we'd need to verify that we didn't get a short
      read due to something intermittent such as low memory. */
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (!e.in_use)
-      break;
+  struct dir_entry es[DIR_SCAN_CNT];
+  size_t cnt, i;
+  bool found = false;
+  for (ofs = 0; !found && (cnt = inode_read_at (dir->inode, es, sizeof es, ofs)
+                                 / sizeof *es) > 0; ) 
+    {
+      for (i = 0; i < cnt && !found; i++)
+        found = !es[i].in_use;
+      ofs += (found ? i - 1 : cnt) * sizeof *es;
+    }
+
+  /* free slot이 없고 entry가 많은 경우 hash index로 변환 */
+  if (!found && ofs / sizeof e >= DIR_INDEX_MIN)
+    {
+      success = index_rebuild (dir, DIR_INDEX_MIN_BITS)
+                && index_insert (dir, &e, false);
+      goto done;
+    }
 
   /* Write slot. */
-  e.in_use = true;
-  strlcpy (e.name, name, sizeof e.name);
-  e.inode_sector = inode_sector;
   success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
  done:
+  /* 추가한 entry를 dcache에 기록 (negative entry 제거) */
+  if (success)
+    dcache_insert (inode_get_inumber (dir->inode), name, inode_sector);
   return success;
 }
 
@@ -254,9 +415,14 @@ dir_remove (struct dir *dir, const char *name)
   if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e) 
     goto done;
 
+  /* 삭제한 directory의 sector는 재사용될 수 있으므로 그 아래의 cache entry 제거 */
+  if (inode_is_dir (inode))
+    dcache_invalidate (e.inode_sector);
+
   /* Remove inode. */
   inode_remove (inode);
   success = true;
+  dcache_insert (inode_get_inumber (dir->inode), name, 0);
 
  done:
   inode_close (inode);
@@ -283,81 +449,107 @@ dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
   return false;
 }
 
-/* "/" 기준으로 "name"을 subdirectory인 "directory"와 파일이름 "file"로 parsing */
-void parse_path (char *name, char *directory, char *file)
+/* DIR의 다음 entry들을 최대 CNT개 ENTS에 저장하고 저장한 entry 수 return
+   (더 이상 entry가 없으면 0)
+   entry를 DIR_SCAN_CNT개씩 read하며, dir_readdir()과 같은 위치 (dir->pos)를 사용 */
+size_t
+dir_readdir_batch (struct dir *dir, struct dirent *ents, size_t cnt)
 {
-  char str[NAME_MAX + 1];
-  strlcpy(str, name, strlen(name) + 1);
-  char *next_ptr;
-  char *ptr = strtok_r(str, "/", &next_ptr);
-
-  /* absolute path */
-  if(name[0] == '/')
-    strlcpy (directory, "/", 2);
-  /* relative path */
-  else
-    strlcpy (directory, "", 1);
-  strlcpy (file, "", 1);
-
-  while (ptr){
-    if(strlen (file)){
-      strlcat (directory, file, strlen (directory) + strlen (file) + 1);
-      strlcat (directory, "/", strlen (directory) + 2);
-    }
+  struct dir_entry es[DIR_SCAN_CNT];
+  size_t n = 0, got, i;
 
-    strlcpy (file, ptr, strlen (ptr) + 1);
-    ptr = strtok_r (NULL, "/", &next_ptr);
-  }
+  while (n < cnt
+         && (got = inode_read_at (dir->inode, es, sizeof es, dir->pos)
+                   / sizeof *es) > 0)
+    for (i = 0; i < got && n < cnt; i++)
+      {
+        dir->pos += sizeof *es;
+        if (!es[i].in_use)
+          continue;
+
+        /* entry가 directory인지 확인 */
+        struct inode *inode = inode_open (es[i].inode_sector);
+        ents[n].inumber = es[i].inode_sector;
+        ents[n].is_dir = inode != NULL && inode_is_dir (inode);
+        inode_close (inode);
+        strlcpy (ents[n].name, es[i].name, sizeof ents[n].name);
+        n++;
+      }
+  return n;
 }
 
-/* parsing한 directory path를 찾아가 해당 directory return */
-struct dir *open_directory_path (char *directory)
+/* PATH의 앞 LEN byte를 directory path로 하여 찾아가 해당 directory return
+   PATH를 복사하거나 수정하지 않고 component 단위로 탐색 */
+static struct dir *walk_path (const char *path, size_t len)
 {
   struct dir *dir;
+  const char *end = path + len;
+  const char *p = path;
+  char name[NAME_MAX + 1];
+
   /* absolute path거나, current working directory init안된 경우 root부터 시작 */
-  if (directory[0] == '/' || thread_current ()->cur_dir == NULL)
+  if (path[0] == '/' || thread_current ()->cur_dir == NULL)
     dir = dir_open_root ();
   /* relative path인 경우 current working directory부터 시작 */
   else
     dir = dir_reopen (thread_current ()->cur_dir); 
+  if (dir == NULL)
+    return NULL;
 
-  char *next_ptr;
-  char *ptr = strtok_r (directory, "/", &next_ptr); 
   /* "/" 기준으로 directory 구분하면서 찾아감 */
-  while(ptr){
+  while (p < end) {
+    const char *start;
+    size_t name_len;
+
+    while (p < end && *p == '/')
+      p++;
+    if (p == end)
+      break;
+    start = p;
+    while (p < end && *p != '/')
+      p++;
+    name_len = p - start;
+
+    /* NAME_MAX보다 긴 이름의 entry는 존재하지 않음 */
+    if (name_len > NAME_MAX) {
+      dir_close (dir);
+      return NULL;
+    }
+    memcpy (name, start, name_len);
+    name[name_len] = '\0';
+
     /* current directory */
-    if (!strcmp (ptr, ".")){
-      ptr = strtok_r (NULL, "/", &next_ptr);
+    if (!strcmp (name, "."))
       continue;
-    }
     /* parent directory */
-    if (!strcmp (ptr, "..")){
+    if (!strcmp (name, "..")){
       struct dir *next_dir = dir_reopen (dir->par);
       dir_close (dir);
       dir = next_dir;
-      ptr = strtok_r (NULL, "/", &next_ptr);
       continue;
     }
 
     struct inode *disk_inode;
 
-    /* "dir" 디렉터리에 "ptr"이라는 entry file(directory) 존재하는지 check */ 
-    if (!dir_lookup (dir, ptr, &disk_inode)){
+    /* "dir" 디렉터리에 "name"이라는 entry file(directory) 존재하는지 check */ 
+    if (!dir_lookup (dir, name, &disk_inode)){
       dir_close (dir);
       return NULL;
     }
 
     /* 존재할 경우 해당 entry가 directory인지 check */
-    if (!inode_is_dir (disk_inode))
+    if (!inode_is_dir (disk_inode)) {
+      inode_close (disk_inode);
+      dir_close (dir);
       return NULL; 
+    }
     
     /* 해당 directory 새로 open 
-       "dir"를 새로 open한 directory로 변경하고,
-       "/" 기준으로 문자열 다시 parsing하여 위 과정 반복 */
-    struct dir *next_dir = dir_open (dir, disk_inode);
-//    dir_close (dir);
-    dir = next_dir;
-    ptr = strtok_r (NULL, "/", &next_ptr);
+       "dir"를 새로 open한 directory로 변경하고, 다음 component에 대해 위 과정 반복 
+       (".." 처리를 위해 parent인 "dir"는 닫지 않음) */
+    dir = dir_open (dir, disk_inode);
+    if (dir == NULL)
+      return NULL;
   } 
 
   /* path를 따라 open한 directory가 이미 remove된 경우 */
@@ -368,3 +560,33 @@ struct dir *open_directory_path (char *directory)
 
   return dir;
 }
+
+/* directory path를 찾아가 해당 directory return */
+struct dir *open_directory_path (const char *directory)
+{
+  return walk_path (directory, strlen (directory));
+}
+
+/* PATH를 마지막 component와 그 앞의 directory path로 나누어
+   마지막 component 이름을 FILE에 저장하고 directory를 open하여 return 
+   (FILE은 "/"만 있는 경우 빈 문자열)
+   마지막 component가 NAME_MAX보다 길면 NULL return */
+struct dir *open_parent_path (const char *path, char file[NAME_MAX + 1])
+{
+  size_t end = strlen (path);
+  size_t start;
+
+  /* 마지막 "/" 무시 */
+  while (end > 0 && path[end - 1] == '/')
+    end--;
+  start = end;
+  while (start > 0 && path[start - 1] != '/')
+    start--;
+
+  if (end - start > NAME_MAX)
+    return NULL;
+  memcpy (file, path + start, end - start);
+  file[end - start] = '\0';
+
+  return walk_path (path, start);
+}
\ No newline at end of file
@@ -13,6 +13,15 @@
 
 struct inode;
 
+/* Directory entry record filled by dir_readdir_batch().
+   Must match the layout of `struct dirent' in lib/user/syscall.h. */
+struct dirent
+  {
+    int inumber;                        /* Inode number. */
+    bool is_dir;                        /* Directory or file? */
+    char name[NAME_MAX + 1];            /* Null terminated file name. */
+  };
+
 /* Opening and closing directories. */
 bool dir_create (block_sector_t sector, size_t entry_cnt);
 struct dir *dir_open (struct dir *, struct inode *);
@@ -26,8 +35,9 @@ bool dir_lookup (const struct dir *, const char *name, struct inode **);
 bool dir_add (struct dir *, const char *name, block_sector_t);
 bool dir_remove (struct dir *, const char *name);
 bool dir_readdir (struct dir *, char name[NAME_MAX + 1]);
+size_t dir_readdir_batch (struct dir *, struct dirent *, size_t cnt);
 
-void parse_path (char *name, char *directory, char *file);	// parse directory, file name
-struct dir *open_directory_path (char *directory); // directory path open
+struct dir *open_parent_path (const char *path, char file[NAME_MAX + 1]); // path의 마지막 component의 directory open
+struct dir *open_directory_path (const char *directory); // directory path open
 
 #endif /* filesys/directory.h */
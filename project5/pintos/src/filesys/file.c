@@ -1,16 +1,28 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include <round.h>
 #include "filesys/inode.h"
+#include "devices/block.h"
 #include "threads/malloc.h"
 
+/* read-ahead window 크기 (sector 단위)
+   순차 read가 계속되면 MIN부터 두 배씩 MAX까지 증가 */
+#define READ_AHEAD_MIN 2
+#define READ_AHEAD_MAX 16
+
 /* An open file. */
 struct file 
   {
     struct inode *inode;        /* File's inode. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
+    off_t ra_next;              /* 순차 read라면 다음 read가 시작할 위치 */
+    off_t ra_end;               /* read-ahead 요청이 끝난 위치 */
+    int ra_window;              /* read-ahead window 크기 (sector 수) */
   };
 
+static void file_read_ahead (struct file *, off_t offset, off_t bytes_read);
+
 /* Opens a file for the given INODE, of which it takes ownership,
    and returns the new file.  Returns a null pointer if an
    allocation fails or if INODE is null. */
@@ -23,6 +35,9 @@ file_open (struct inode *inode)
       file->inode = inode;
       file->pos = 0;
       file->deny_write = false;
+      file->ra_next = 0;
+      file->ra_end = 0;
+      file->ra_window = 0;
       return file;
     }
   else
@@ -69,10 +84,50 @@ off_t
 file_read (struct file *file, void *buffer, off_t size) 
 {
   off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+  file_read_ahead (file, file->pos, bytes_read);
   file->pos += bytes_read;
   return bytes_read;
 }
 
+/* OFFSET에서 BYTES_READ byte를 읽은 FILE의 순차 접근 여부를 확인하여
+   순차 접근이라면 window를 키우고, 다음 window만큼의 sector를 read-ahead 요청
+   순차 접근이 아니라면 window를 초기화 */
+static void
+file_read_ahead (struct file *file, off_t offset, off_t bytes_read) 
+{
+  off_t start, end;
+
+  if (bytes_read <= 0)
+    return;
+
+  /* 이전 read가 끝난 위치에서 시작하지 않은 경우 random access */
+  if (offset != file->ra_next)
+    {
+      file->ra_next = offset + bytes_read;
+      file->ra_end = 0;
+      file->ra_window = 0;
+      return;
+    }
+  file->ra_next = offset + bytes_read;
+
+  if (file->ra_window == 0)
+    file->ra_window = READ_AHEAD_MIN;
+  else if (file->ra_window < READ_AHEAD_MAX)
+    file->ra_window *= 2;
+
+  /* 이미 요청한 sector는 제외하고 window 끝까지 요청 */
+  start = ROUND_UP (file->ra_next, BLOCK_SECTOR_SIZE);
+  if (start < file->ra_end)
+    start = file->ra_end;
+  end = ROUND_UP (file->ra_next, BLOCK_SECTOR_SIZE)
+        + file->ra_window * BLOCK_SECTOR_SIZE;
+  if (start >= end)
+    return;
+
+  inode_read_ahead (file->inode, start, (end - start) / BLOCK_SECTOR_SIZE);
+  file->ra_end = end;
+}
+
 /* Reads SIZE bytes from FILE into BUFFER,
    starting at offset FILE_OFS in the file.
    Returns the number of bytes actually read,
@@ -6,6 +6,8 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/dcache.h"
 
 /* Partition that contains the file system. */
 struct block *fs_device;
@@ -21,7 +23,10 @@ filesys_init (bool format)
   if (fs_device == NULL)
     PANIC ("No file system device found, can't initialize file system.");
 
+  /* hash table이 malloc을 사용하므로 malloc_init() 이후에 init */
+  buffer_cache_init ();
   inode_init ();
+  dcache_init ();
   free_map_init ();
 
   if (format) 
@@ -50,10 +55,8 @@ filesys_create (const char *name, off_t initial_size, bool is_dir)
   block_sector_t inode_sector = 0;
   /* 기존 root에서 파일 create하는 방식
   -> subdirectory를 parsing하여, 해당 directory의 파일을 create하는 방식으로 변경 */
-  char *directory = (char *)malloc(sizeof(char) * (strlen(name) + 1));
-  char *file = (char *)malloc(sizeof(char) * (NAME_MAX + 1));
-  parse_path (name, directory, file);	// "name" parsing하여 directory path와 생성할 file(directory) name 구분 
-  struct dir *dir = open_directory_path (directory); // parsing한 subdirectory open 
+  char file[NAME_MAX + 1];
+  struct dir *dir = open_parent_path (name, file); // "name"의 subdirectory open, 생성할 file(directory) name은 "file"에 저장
 
   /* directory에 entry추가하여 inode_sector에 저장 */  
   bool success = (dir != NULL
@@ -64,8 +67,6 @@ filesys_create (const char *name, off_t initial_size, bool is_dir)
     free_map_release (inode_sector, 1);
   dir_close (dir);
 
-  free(directory);
-  free(file);
   return success;
 }
 
@@ -83,10 +84,8 @@ filesys_open (const char *name)
 
   /* 기존 root에서 파일 open하는 방식
   -> subdirectory를 parsing하여, 해당 directory의 파일을 open하는 방식으로 변경 */
-  char *directory = (char *)malloc(sizeof(char) * (strlen(name) + 1));
-  char *file = (char *)malloc(sizeof(char) * (NAME_MAX + 1));
-  parse_path (name, directory, file);
-  struct dir *dir = open_directory_path (directory);
+  char file[NAME_MAX + 1];
+  struct dir *dir = open_parent_path (name, file);
   struct inode *inode = NULL;
 
 
@@ -106,10 +105,8 @@ filesys_remove (const char *name)
 {
   /* 기존 root에서 파일 remove하는 방식
   -> subdirectory를 parsing하여, 해당 directory의 파일을 remove하는 방식으로 변경 */
-  char *directory = (char *)malloc(sizeof(char) * (strlen(name) + 1));
-  char *file = (char *)malloc(sizeof(char) * (NAME_MAX + 1));
-  parse_path (name, directory, file);
-  struct dir *dir = open_directory_path (directory);
+  char file[NAME_MAX + 1];
+  struct dir *dir = open_parent_path (name, file);
   
   bool success = dir != NULL && dir_remove (dir, file);
   dir_close (dir); 
@@ -1,12 +1,22 @@
 #include "filesys/free-map.h"
 #include <bitmap.h>
 #include <debug.h>
+#include <round.h>
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/synch.h"
+
+/* Number of free map bits stored in one sector of the free map file. */
+#define BITS_PER_SECTOR (BLOCK_SECTOR_SIZE * 8)
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
+static struct bitmap *free_map_dirty; /* Dirty bit per free map file sector. */
+static struct lock free_map_lock;    /* Protects free_map and free_map_dirty. */
+static size_t free_map_hint;         /* Where the next search without a goal starts. */
+
+static void mark_dirty (block_sector_t sector, size_t cnt);
 
 /* Initializes the free map. */
 void
@@ -17,36 +27,128 @@ free_map_init (void)
     PANIC ("bitmap creation failed--file system device is too large");
   bitmap_mark (free_map, FREE_MAP_SECTOR);
   bitmap_mark (free_map, ROOT_DIR_SECTOR);
+
+  /* bitmap 전체 대신 변경된 sector만 기록하기 위한 dirty bitmap */
+  free_map_dirty = bitmap_create (DIV_ROUND_UP (block_size (fs_device),
+                                                BITS_PER_SECTOR));
+  if (free_map_dirty == NULL)
+    PANIC ("bitmap creation failed--file system device is too large");
+  lock_init (&free_map_lock);
+}
+
+/* Marks the free map file sectors holding the bits for CNT
+   sectors starting at SECTOR as dirty. */
+static void
+mark_dirty (block_sector_t sector, size_t cnt)
+{
+  size_t first = sector / BITS_PER_SECTOR;
+  size_t last = (sector + cnt - 1) / BITS_PER_SECTOR;
+  bitmap_set_multiple (free_map_dirty, first, last - first + 1, true);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
    the first into *SECTORP.
+   The search starts where the previous one left off and wraps
+   around to the start of the disk.
    Returns true if successful, false if not enough consecutive
-   sectors were available or if the free_map file could not be
-   written. */
+   sectors were available.
+   The change only reaches the free map file at the next
+   free_map_flush(). */
 bool
 free_map_allocate (size_t cnt, block_sector_t *sectorp)
 {
-  block_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
-  if (sector != BITMAP_ERROR
-      && free_map_file != NULL
-      && !bitmap_write (free_map, free_map_file))
+  block_sector_t sector;
+
+  lock_acquire (&free_map_lock);
+  sector = bitmap_scan_and_flip (free_map, free_map_hint, cnt, false);
+  if (sector == BITMAP_ERROR && free_map_hint != 0)
+    sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
+  if (sector != BITMAP_ERROR)
     {
-      bitmap_set_multiple (free_map, sector, cnt, false); 
-      sector = BITMAP_ERROR;
+      mark_dirty (sector, cnt);
+      free_map_hint = (sector + cnt) % bitmap_size (free_map);
+      *sectorp = sector;
     }
-  if (sector != BITMAP_ERROR)
-    *sectorp = sector;
+  lock_release (&free_map_lock);
   return sector != BITMAP_ERROR;
 }
 
-/* Makes CNT sectors starting at SECTOR available for use. */
+/* Allocates a run of between 1 and MAX_CNT consecutive sectors,
+   starting at the first free sector at or after GOAL, and stores
+   the first into *SECTORP.  A GOAL of 0 or past the end of the
+   disk means no preference, in which case the search starts at
+   the rotating hint.  The search wraps around to the start of
+   the disk.
+   Returns the number of sectors allocated, 0 if the disk is
+   full.
+   The change only reaches the free map file at the next
+   free_map_flush(). */
+size_t
+free_map_allocate_near (block_sector_t goal, size_t max_cnt,
+                        block_sector_t *sectorp)
+{
+  size_t size = bitmap_size (free_map);
+  size_t start, cnt = 0;
+
+  ASSERT (max_cnt > 0);
+
+  lock_acquire (&free_map_lock);
+  if (goal == 0 || goal >= size)
+    goal = free_map_hint;
+  start = bitmap_scan (free_map, goal, 1, false);
+  if (start == BITMAP_ERROR && goal != 0)
+    start = bitmap_scan (free_map, 0, 1, false);
+  if (start != BITMAP_ERROR)
+    {
+      /* goal 이후 첫 free sector부터 가능한 만큼 연속 할당 */
+      cnt = 1;
+      while (cnt < max_cnt && start + cnt < size
+             && !bitmap_test (free_map, start + cnt))
+        cnt++;
+      bitmap_set_multiple (free_map, start, cnt, true);
+      mark_dirty (start, cnt);
+      free_map_hint = (start + cnt) % size;
+      *sectorp = start;
+    }
+  lock_release (&free_map_lock);
+  return cnt;
+}
+
+/* Makes CNT sectors starting at SECTOR available for use.
+   The change only reaches the free map file at the next
+   free_map_flush(). */
 void
 free_map_release (block_sector_t sector, size_t cnt)
 {
+  lock_acquire (&free_map_lock);
   ASSERT (bitmap_all (free_map, sector, cnt));
   bitmap_set_multiple (free_map, sector, cnt, false);
-  bitmap_write (free_map, free_map_file);
+  mark_dirty (sector, cnt);
+  lock_release (&free_map_lock);
+}
+
+/* Writes the dirty sectors of the free map to the free map file.
+   The writes go through the buffer cache, so a sector changed by
+   many allocations is written to disk once. */
+void
+free_map_flush (void)
+{
+  size_t idx;
+
+  if (free_map_file == NULL)
+    return;
+
+  lock_acquire (&free_map_lock);
+  for (idx = bitmap_scan (free_map_dirty, 0, 1, true);
+       idx != BITMAP_ERROR;
+       idx = bitmap_scan (free_map_dirty, idx + 1, 1, true))
+    {
+      if (!bitmap_write_part (free_map, free_map_file,
+                              idx * BLOCK_SECTOR_SIZE, BLOCK_SECTOR_SIZE))
+        PANIC ("can't write free map");
+      bitmap_reset (free_map_dirty, idx);
+    }
+  lock_release (&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -64,6 +166,7 @@ free_map_open (void)
 void
 free_map_close (void) 
 {
+  free_map_flush ();
   file_close (free_map_file);
 }
 
@@ -82,4 +185,5 @@ free_map_create (void)
     PANIC ("can't open free map");
   if (!bitmap_write (free_map, free_map_file))
     PANIC ("can't write free map");
+  bitmap_set_all (free_map_dirty, false);
 }
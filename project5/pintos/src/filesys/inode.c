@@ -1,29 +1,43 @@
 #include "filesys/inode.h"
+#include <hash.h>
 #include <list.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/buffer_cache.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* inode의 direct block 수, 나머지 word는 indirect, double indirect, 기타 정보 */
+#define DIRECT_CNT 123
+/* indirect block 하나가 가리키는 block 수 */
+#define INDIRECT_CNT 128
+
 /* On-disk inode.
-   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. 
+   file의 첫 DIRECT_CNT개 sector는 direct block,
+   다음 INDIRECT_CNT개 sector는 indirect block,
+   나머지는 double indirect block을 통해 찾음 */
 struct inode_disk
   {
+    block_sector_t direct[DIRECT_CNT];  /* direct blocks */
+    block_sector_t indirect;            /* indirect block */
     block_sector_t double_indirect;     /* double_indirect_block */
     bool is_dir;			/* directory or file */
+    uint8_t dir_index_bits;             /* hash index된 directory의 log2 (slot 수), 0: index 없음 */
     off_t length;                       /* File size in bytes. */
     unsigned magic;                     /* Magic number. */
-    uint32_t unused[124];               /* Not used. */
   };
 
 struct indirect
   {
-    block_sector_t block[128];	// 512 Byte (BLOCK SECTOR size)
+    block_sector_t block[INDIRECT_CNT];	// 512 Byte (BLOCK SECTOR size)
   };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -37,51 +51,177 @@ bytes_to_sectors (off_t size)
 /* In-memory inode. */
 struct inode 
   {
-    struct list_elem elem;              /* Element in inode list. */
+    struct hash_elem elem;              /* Element in open_inodes. */
     block_sector_t sector;              /* Sector number of disk location. */
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
     struct inode_disk data;             /* Inode content. */
+    struct rw_lock rw;                  /* data 접근 lock (read, 기존 block write는 shared,
+                                           block 할당, file extension은 exclusive) */
+    struct lock map_lock;               /* map_idx, map_block 보호 */
+    off_t map_idx;                      /* map_block 번호, -1: 없음 
+                                           (0: indirect, 1~: double indirect의 idx + 1) */
+    struct indirect map_block;          /* 마지막으로 참조한 single indirect block */
   };
 
-bool double_indirect_block_allocate (struct inode_disk *disk_inode, size_t sectors);	/* double indirect block allocation */
-void double_indirect_block_deallocate (struct inode *inode);				/* double indirect block deallocation */
+/* index block (inode, indirect block) 등 sector 단위 read/write
+   data block과 같은 sector를 일관되게 보도록 모두 buffer cache를 거침 */
+static void
+sector_read (block_sector_t sector, void *buffer)
+{
+  buffer_cache_read (sector, buffer, BLOCK_SECTOR_SIZE, 0, 0);
+}
+
+static void
+sector_write (block_sector_t sector, const void *buffer)
+{
+  buffer_cache_write (sector, buffer, BLOCK_SECTOR_SIZE, 0, 0);
+}
+
+/* INODE의 block mapping이 바뀌었으므로 map_block을 무효화 */
+static void
+inode_map_invalidate (struct inode *inode)
+{
+  lock_acquire (&inode->map_lock);
+  inode->map_idx = -1;
+  lock_release (&inode->map_lock);
+}
+
+bool inode_block_allocate (struct inode *inode, size_t first, size_t last);	/* direct, indirect, double indirect block allocation */
+void inode_block_deallocate (struct inode *inode);				/* direct, indirect, double indirect block deallocation */
+
+/* INODE의 IDX번째 sector에 해당하는 disk sector return
+   할당되지 않은 block (hole)이면 0 return */
+static block_sector_t
+index_to_sector (struct inode *inode, size_t idx)
+{
+  size_t map_idx;
+  block_sector_t sector;
+
+  /* direct block: 추가 metadata read 없음 */
+  if (idx < DIRECT_CNT)
+    return inode->data.direct[idx];
+  idx -= DIRECT_CNT;
+
+  /* indirect block이면 0번, double indirect block이면 (idx / 128) + 1번 map block */
+  if (idx < INDIRECT_CNT)
+    map_idx = 0;
+  else {
+    idx -= INDIRECT_CNT;
+    if (idx >= INDIRECT_CNT * INDIRECT_CNT)
+      return 0;
+    map_idx = idx / INDIRECT_CNT + 1;
+    idx %= INDIRECT_CNT;
+  }
+
+  lock_acquire (&inode->map_lock);
+  /* 마지막으로 참조한 indirect block이 아닌 경우에만 buffer cache에서 read */
+  if (inode->map_idx != (off_t) map_idx){
+    block_sector_t map_sector = inode->data.indirect;
+    if (map_idx > 0){
+      map_sector = 0;
+      if (inode->data.double_indirect != 0)
+        buffer_cache_read (inode->data.double_indirect, (uint8_t *) &map_sector,
+                           sizeof map_sector, 0, (map_idx - 1) * sizeof map_sector);
+    }
+    /* indirect block 자체가 hole인 경우 */
+    if (map_sector == 0){
+      lock_release (&inode->map_lock);
+      return 0;
+    }
+    sector_read (map_sector, &inode->map_block);
+    inode->map_idx = map_idx;
+  }
+  sector = inode->map_block.block[idx];
+  lock_release (&inode->map_lock);
+  return sector;
+}
 
 /* Returns the block device sector that contains byte offset POS
    within INODE.
+   Returns 0 if that part of INODE is a hole (reads as zeros).
    Returns -1 if INODE does not contain data for a byte at offset
    POS. */
 static block_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) 
+byte_to_sector (struct inode *inode, off_t pos) 
 {
   ASSERT (inode != NULL);
-  if (pos < inode->data.length){
-    /* continuous block alloc 방식에서 offset에 해당하는 sector 찾는 방식
-    -> double indirect block alloc 방식에서 offset에 해당하는 sector 찾는 방식 */
-    off_t double_idx = (pos / BLOCK_SECTOR_SIZE) / 128;
-    off_t single_idx = (pos / BLOCK_SECTOR_SIZE) % 128;
-    struct indirect ind_block;
-
-    block_read (fs_device, inode->data.double_indirect, &ind_block);
-    block_read (fs_device, ind_block.block[double_idx], &ind_block);
-    return ind_block.block[single_idx];
-  }
+  if (pos < inode->data.length)
+    return index_to_sector (inode, pos / BLOCK_SECTOR_SIZE);
   else
     return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
-   returns the same `struct inode'. */
-static struct list open_inodes;
-char buf[BLOCK_SECTOR_SIZE];	// to fill with zero when block sector allocated
+/* Open inodes keyed by sector, so that opening a single inode
+   twice returns the same `struct inode'. */
+static struct hash open_inodes;
+static struct lock open_inodes_lock;  /* Protects open_inodes and open_cnt. */
+
+/* open_inodes hash function: inode sector 번호 */
+static unsigned
+open_inodes_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct inode *inode = hash_entry (e, struct inode, elem);
+  return hash_int (inode->sector);
+}
+
+static bool
+open_inodes_less (const struct hash_elem *a, const struct hash_elem *b,
+                  void *aux UNUSED)
+{
+  return hash_entry (a, struct inode, elem)->sector
+         < hash_entry (b, struct inode, elem)->sector;
+}
+
+/* SECTOR의 inode가 열려 있다면 return, 없으면 NULL
+   open_inodes_lock을 잡은 상태에서 호출 */
+static struct inode *
+open_inodes_find (block_sector_t sector)
+{
+  struct inode key;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&open_inodes_lock));
+  key.sector = sector;
+  e = hash_find (&open_inodes, &key.elem);
+  return e != NULL ? hash_entry (e, struct inode, elem) : NULL;
+}
+
+/* read-ahead 요청 
+   INODE의 OFFSET부터 SECTOR_CNT개의 sector를 buffer cache에 미리 load */
+struct read_ahead
+  {
+    struct inode *inode;	// 요청 시 reopen, 처리 후 close
+    off_t offset;
+    int sector_cnt;
+  };
+
+#define READ_AHEAD_QUEUE_SIZE 16
+
+/* read-ahead worker thread가 처리할 요청 queue (circular) */
+static struct read_ahead read_ahead_queue[READ_AHEAD_QUEUE_SIZE];
+static int read_ahead_head;		// 다음에 처리할 요청 idx
+static int read_ahead_cnt;		// queue에 있는 요청 수
+static struct lock read_ahead_lock;
+static struct condition read_ahead_cond;	// 요청이 들어오면 signal
+
+static void read_ahead_worker (void *aux);
 
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
-  list_init (&open_inodes);
-  memset (buf, 0, BLOCK_SECTOR_SIZE);
+  /* hash table이 malloc을 사용하므로 malloc_init() 이후에 init */
+  hash_init (&open_inodes, open_inodes_hash, open_inodes_less, NULL);
+  lock_init (&open_inodes_lock);
+
+  /* read-ahead worker 생성 */
+  read_ahead_head = 0;
+  read_ahead_cnt = 0;
+  lock_init (&read_ahead_lock);
+  cond_init (&read_ahead_cond);
+  thread_create ("read-ahead", PRI_DEFAULT, read_ahead_worker, NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -104,18 +244,15 @@ inode_create (block_sector_t sector, off_t length, bool is_dir)
   disk_inode = calloc (1, sizeof *disk_inode);
   if (disk_inode != NULL)
     {
-      size_t sectors = bytes_to_sectors (length);
       disk_inode->is_dir = is_dir;
       disk_inode->length = length;
       disk_inode->magic = INODE_MAGIC;
 
-      /* continuous block allocation 방식
-      -> double indirect block allocation 방식 */    
-      if(double_indirect_block_allocate (disk_inode, sectors))
-        {
-	  block_write (fs_device, sector, disk_inode);
-          success = true; 
-        } 
+      /* data block은 처음 write될 때 할당 (그 전까지는 hole로 0을 read) */
+      sector_write (sector, disk_inode);
+      success = true; 
+      /* 변경된 free map sector (inode sector)만 한 번에 기록 */
+      free_map_flush ();
       free (disk_inode);
     }
   return success;
@@ -127,33 +264,47 @@ inode_create (block_sector_t sector, off_t length, bool is_dir)
 struct inode *
 inode_open (block_sector_t sector)
 {
-  struct list_elem *e;
-  struct inode *inode;
+  struct inode *inode, *open;
 
   /* Check whether this inode is already open. */
-  for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-       e = list_next (e)) 
-    {
-      inode = list_entry (e, struct inode, elem);
-      if (inode->sector == sector) 
-        {
-          inode_reopen (inode);
-          return inode; 
-        }
-    }
+  lock_acquire (&open_inodes_lock);
+  inode = open_inodes_find (sector);
+  if (inode != NULL)
+    inode->open_cnt++;
+  lock_release (&open_inodes_lock);
+  if (inode != NULL)
+    return inode;
 
   /* Allocate memory. */
   inode = malloc (sizeof *inode);
   if (inode == NULL)
     return NULL;
 
-  /* Initialize. */
-  list_push_front (&open_inodes, &inode->elem);
+  /* Initialize. 
+     disk read 동안 다른 inode의 open을 막지 않도록 lock 없이 read */
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
-  block_read (fs_device, inode->sector, &inode->data);
+  rw_lock_init (&inode->rw);
+  lock_init (&inode->map_lock);
+  inode->map_idx = -1;
+  sector_read (inode->sector, &inode->data);
+
+  /* 그 사이 다른 thread가 같은 inode를 open했다면 그 inode를 사용 */
+  lock_acquire (&open_inodes_lock);
+  open = open_inodes_find (sector);
+  if (open != NULL)
+    open->open_cnt++;
+  else
+    hash_insert (&open_inodes, &inode->elem);
+  lock_release (&open_inodes_lock);
+
+  if (open != NULL)
+    {
+      free (inode);
+      return open;
+    }
   return inode;
 }
 
@@ -162,7 +313,11 @@ struct inode *
 inode_reopen (struct inode *inode)
 {
   if (inode != NULL)
-    inode->open_cnt++;
+    {
+      lock_acquire (&open_inodes_lock);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+    }
   return inode;
 }
 
@@ -184,18 +339,22 @@ inode_close (struct inode *inode)
     return;
 
   /* Release resources if this was the last opener. */
-  if (--inode->open_cnt == 0)
+  lock_acquire (&open_inodes_lock);
+  bool last = --inode->open_cnt == 0;
+  if (last)
+    hash_delete (&open_inodes, &inode->elem);
+  lock_release (&open_inodes_lock);
+
+  if (last)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
-	
       /* Deallocate blocks if removed. */
       if (inode->removed) 
         {
 	  /* continuous block alloc 방식의 deallocation
-          -> double indirect block alloc 방식의 deallocation */
+          -> direct, indirect, double indirect block alloc 방식의 deallocation */
           free_map_release (inode->sector, 1);
-          double_indirect_block_deallocate (inode);
+          inode_block_deallocate (inode);
+          free_map_flush ();
         }
 
       free (inode); 
@@ -221,6 +380,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
   off_t bytes_read = 0;
   uint8_t *bounce = NULL;
 
+  /* 다른 reader와는 동시에, file extension과는 배타적으로 read */
+  rw_lock_acquire_read (&inode->rw);
   while (size > 0) 
     {
       /* Disk sector to read, starting byte offset within sector. */
@@ -240,13 +401,18 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       /* Advance. */
       /* Read from disk 방식
       -> Read from Buffer Cache 방식 */
-      buffer_cache_read (sector_idx, buffer, chunk_size, bytes_read, sector_ofs);
+      /* hole은 disk I/O 없이 0으로 read */
+      if (sector_idx == 0)
+        memset (buffer + bytes_read, 0, chunk_size);
+      else
+        buffer_cache_read (sector_idx, buffer, chunk_size, bytes_read, sector_ofs);
 
       size -= chunk_size;
       offset += chunk_size;
       bytes_read += chunk_size;
     }
   free (bounce);
+  rw_lock_release_read (&inode->rw);
 
   return bytes_read;
 }
@@ -267,29 +433,49 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   if (inode->deny_write_cnt)
     return 0;
 
-  /* 기존 file의 크기를 초과하는 위치에 write하는 경우 file extension */
-  if (inode_length (inode) < offset + size) {
-    if(!double_indirect_block_allocate (&inode->data, bytes_to_sectors (offset + size)))
-      return 0;
-    inode->data.length = offset + size;
-    block_write (fs_device, inode->sector, &inode->data); 
-  }
+  size_t last = bytes_to_sectors (offset + size);
+  bool allocated = false;
+
+  /* 할당된 block 안의 write는 다른 reader, writer와 동시에 진행 (sector 단위 보호는 buffer cache)
+     file extension은 처음부터 exclusive로 진행 */
+  bool exclusive = inode_length (inode) < offset + size;
+  if (exclusive)
+    rw_lock_acquire_write (&inode->rw);
+  else
+    rw_lock_acquire_read (&inode->rw);
 
   while (size > 0) 
     {
       /* Sector to write, starting byte offset within sector. */
-      block_sector_t sector_idx = byte_to_sector (inode, offset);
+      size_t idx = offset / BLOCK_SECTOR_SIZE;
+      block_sector_t sector_idx = index_to_sector (inode, idx);
       int sector_ofs = offset % BLOCK_SECTOR_SIZE;
 
-      /* Bytes left in inode, bytes left in sector, lesser of the two. */
-      off_t inode_left = inode_length (inode) - offset;
+      /* hole이거나 file 끝을 넘는 경우, write할 나머지 범위의 block을 한 번에 할당
+         (write하지 않는 범위는 hole로 남음) */
+      if (sector_idx == 0)
+        {
+          /* hole에 write하는 경우 block 할당을 위해 exclusive로 다시 획득한 뒤 다시 확인 */
+          if (!exclusive)
+            {
+              rw_lock_release_read (&inode->rw);
+              rw_lock_acquire_write (&inode->rw);
+              exclusive = true;
+              continue;
+            }
+          inode_block_allocate (inode, idx, last);
+          inode_map_invalidate (inode);
+          allocated = true;
+          sector_idx = index_to_sector (inode, idx);
+          if (sector_idx == 0)
+            break;
+        }
+
+      /* Bytes left in sector. */
       int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
-      int min_left = inode_left < sector_left ? inode_left : sector_left;
 
       /* Number of bytes to actually write into this sector. */
-      int chunk_size = size < min_left ? size : min_left;
-      if (chunk_size <= 0)
-        break;
+      int chunk_size = size < sector_left ? size : sector_left;
 
       /* Advance. */
       /* Write to disk 방식
@@ -302,9 +488,79 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
     }
   free (bounce);
 
+  /* 기존 file의 크기를 초과하는 위치까지 write한 경우 file extension */
+  bool extended = bytes_written > 0 && inode_length (inode) < offset;
+  if (extended)
+    inode->data.length = offset;
+  if (allocated || extended)
+    sector_write (inode->sector, &inode->data); 
+
+  if (exclusive)
+    rw_lock_release_write (&inode->rw);
+  else
+    rw_lock_release_read (&inode->rw);
+
+  /* 변경된 free map sector만 한 번에 기록
+     free map file에 대한 write일 수도 있으므로 rw lock을 놓은 뒤에 기록 */
+  if (allocated)
+    free_map_flush ();
+
   return bytes_written;
 }
 
+/* INODE의 OFFSET부터 SECTOR_CNT개의 sector를 background에서 buffer cache로 read
+   queue가 가득 찬 경우 요청은 버림 (read-ahead는 hint일 뿐이므로) */
+void
+inode_read_ahead (struct inode *inode, off_t offset, int sector_cnt)
+{
+  if (sector_cnt <= 0 || offset >= inode_length (inode))
+    return;
+
+  lock_acquire (&read_ahead_lock);
+  if (read_ahead_cnt < READ_AHEAD_QUEUE_SIZE)
+    {
+      struct read_ahead *ra = &read_ahead_queue[(read_ahead_head + read_ahead_cnt)
+                                                % READ_AHEAD_QUEUE_SIZE];
+      ra->inode = inode_reopen (inode);
+      ra->offset = offset;
+      ra->sector_cnt = sector_cnt;
+      read_ahead_cnt++;
+      cond_signal (&read_ahead_cond, &read_ahead_lock);
+    }
+  lock_release (&read_ahead_lock);
+}
+
+/* read-ahead 요청을 하나씩 꺼내 buffer cache에 load하는 kernel thread */
+static void
+read_ahead_worker (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct read_ahead ra;
+
+      /* 요청이 들어올 때까지 대기 */
+      lock_acquire (&read_ahead_lock);
+      while (read_ahead_cnt == 0)
+        cond_wait (&read_ahead_cond, &read_ahead_lock);
+      ra = read_ahead_queue[read_ahead_head];
+      read_ahead_head = (read_ahead_head + 1) % READ_AHEAD_QUEUE_SIZE;
+      read_ahead_cnt--;
+      lock_release (&read_ahead_lock);
+
+      /* file 끝을 넘지 않는 sector만 load */
+      for (int i = 0; i < ra.sector_cnt; i++)
+        {
+          off_t pos = ra.offset + i * BLOCK_SECTOR_SIZE;
+          if (pos >= inode_length (ra.inode))
+            break;
+          block_sector_t sector = byte_to_sector (ra.inode, pos);
+          if (sector != 0)
+            buffer_cache_prefetch (sector);
+        }
+      inode_close (ra.inode);
+    }
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
@@ -338,6 +594,20 @@ bool inode_is_dir (const struct inode *inode)
   return inode->data.is_dir;
 }
 
+/* hash index된 directory의 log2 (slot 수) return, index 없는 경우 0 */
+int inode_dir_index_bits (const struct inode *inode)
+{
+  return inode->data.dir_index_bits;
+}
+
+/* directory의 hash index 크기 변경 후 disk에 기록 */
+void inode_set_dir_index_bits (struct inode *inode, int bits)
+{
+  ASSERT (inode->data.is_dir);
+  inode->data.dir_index_bits = bits;
+  sector_write (inode->sector, &inode->data);
+}
+
 /* inode remove 여부 return */
 bool inode_is_remove (const struct inode *inode)
 {
@@ -349,78 +619,160 @@ int inode_open_cnt (const struct inode *inode)
   return inode->open_cnt;
 }
 
-/* double indirect block allocation */
-bool double_indirect_block_allocate (struct inode_disk *disk_inode, size_t sectors)
+/* *SECTORP가 할당되지 않았다면 *GOAL 근처에 새로 할당하고 buffer cache에서 zero로 채움 */
+static bool block_allocate (block_sector_t *sectorp, block_sector_t *goal)
 {
-  if(!disk_inode->double_indirect){
-    if(!free_map_allocate (1, &disk_inode->double_indirect))
-      return false;
-    /* fill with zero */
-    block_write (fs_device, disk_inode->double_indirect, buf);
-  }
+  if(*sectorp)
+    return true;
+  if(free_map_allocate_near (*goal, 1, sectorp) == 0)
+    return false;
+  /* fill with zero (disk write 없음) */
+  buffer_cache_zero (*sectorp);
+  *goal = *sectorp + 1;
+  return true;
+}
 
-  struct indirect double_indirect;	// double indirect block
-  block_read (fs_device, disk_inode->double_indirect, &double_indirect);
-
-  int mod_sector = sectors % 128;
-  int double_idx = DIV_ROUND_UP(sectors, 128);
-  int single_idx = 128;
- 
-  for(int i=0; i<double_idx; i++){
-    if(i == (double_idx - 1))
-      single_idx = mod_sector ? mod_sector : 128;
-    
-    if(!double_indirect.block[i]){
-      if(!free_map_allocate (1, &double_indirect.block[i]))
-        return false;
-      /* fill with zero */
-      block_write (fs_device, double_indirect.block[i], buf);
-    }
+/* SLOTS[FROM..TO) 중 할당되지 않은 block을 *GOAL부터 연속된 sector로 할당
+   할당되지 않은 slot이 이어지는 만큼 한 번에 요청
+   *GOAL은 다음 할당을 위해 마지막 block의 다음 sector로 갱신 */
+static bool blocks_allocate (block_sector_t *slots, size_t from, size_t to, block_sector_t *goal)
+{
+  size_t i = from;
 
-    struct indirect single_indirect;	// single indirect block
-    block_read (fs_device, double_indirect.block[i], &single_indirect);
+  while(i < to){
+    if(slots[i]){
+      *goal = slots[i++] + 1;
+      continue;
+    }
 
-    for(int j=0; j < single_idx; j++){
-      if(!single_indirect.block[j]){	// data block
-        if(!free_map_allocate (1, &single_indirect.block[j]))
-          return false;
-        /* fill with zero */
-	block_write (fs_device, single_indirect.block[j], buf);
-      }
+    size_t run = 1, got;
+    block_sector_t start;
+    while(i + run < to && slots[i + run] == 0)
+      run++;
+    got = free_map_allocate_near (*goal, run, &start);
+    if(got == 0)
+      return false;
+    for(size_t k=0; k<got; k++){
+      slots[i + k] = start + k;
+      /* fill with zero (disk write 없음) */
+      buffer_cache_zero (start + k);
     }
-    /* single indirect block 저장 */
-    block_write (fs_device, double_indirect.block[i], &single_indirect);
+    *goal = start + got;
+    i += got;
   }
-  /* double indirect block 저장 */
-  block_write (fs_device, disk_inode->double_indirect, &double_indirect);
   return true;
 }
 
-void double_indirect_block_deallocate (struct inode *inode)
+/* *SECTORP의 indirect block과, 그 indirect block이 가리키는 FROM~TO-1번째 block 할당 */
+static bool indirect_block_allocate (block_sector_t *sectorp, size_t from, size_t to, block_sector_t *goal)
+{
+  struct indirect ind_block;
+  bool success;
+
+  if(!block_allocate (sectorp, goal))
+    return false;
+
+  sector_read (*sectorp, &ind_block);
+  success = blocks_allocate (ind_block.block, from, to, goal);
+  /* 일부만 할당된 경우에도 할당한 block을 잃지 않도록 저장 */
+  sector_write (*sectorp, &ind_block);
+  return success;
+}
+
+/* SECTOR의 indirect block과, 그 indirect block이 가리키는 모든 block free */
+static void indirect_block_deallocate (block_sector_t sector)
 {
-  off_t length = inode->data.length;
-  size_t sectors = bytes_to_sectors (length);
+  struct indirect ind_block;
 
-  int mod_sector = sectors % 128;
-  int double_idx = DIV_ROUND_UP (sectors, 128);
-  int single_idx = 128;
+  sector_read (sector, &ind_block);
+  for(size_t i=0; i<INDIRECT_CNT; i++)
+    if(ind_block.block[i])
+      free_map_release (ind_block.block[i], 1);
+  free_map_release (sector, 1);
+}
 
-  struct indirect double_indirect;	// double indirect block
-  block_read (fs_device, inode->data.double_indirect, &double_indirect); 
+/* INODE의 FIRST~LAST-1번째 sector 중 hole인 block 할당
+   (direct -> indirect -> double indirect 순서)
+   file이 disk에서 연속되도록 FIRST 바로 앞 block (없으면 inode sector)의 
+   다음 sector부터 할당
+   inode->data는 수정만 하고 disk에 write하지 않음 */
+bool inode_block_allocate (struct inode *inode, size_t first, size_t last)
+{
+  struct inode_disk *disk_inode = &inode->data;
+  block_sector_t goal = inode->sector + 1;
+  size_t to;
+
+  if(first > 0){
+    block_sector_t prev = index_to_sector (inode, first - 1);
+    if(prev != 0)
+      goal = prev + 1;
+  }
 
-  for(int i=0; i < double_idx; i++){
-    if(i == (double_idx - 1))
-      single_idx = mod_sector ? mod_sector : 128;
+  /* direct block */
+  if(first < DIRECT_CNT){
+    to = last < DIRECT_CNT ? last : DIRECT_CNT;
+    if(!blocks_allocate (disk_inode->direct, first, to, &goal))
+      return false;
+    first = to;
+  }
+  if(first >= last)
+    return true;
+  first -= DIRECT_CNT;
+  last -= DIRECT_CNT;
+
+  /* indirect block */
+  if(first < INDIRECT_CNT){
+    to = last < INDIRECT_CNT ? last : INDIRECT_CNT;
+    if(!indirect_block_allocate (&disk_inode->indirect, first, to, &goal))
+      return false;
+    first = to;
+  }
+  if(first >= last)
+    return true;
+  first -= INDIRECT_CNT;
+  last -= INDIRECT_CNT;
+
+  /* double indirect block (최대 file 크기를 넘는 부분은 할당하지 않음) */
+  if(first >= INDIRECT_CNT * INDIRECT_CNT)
+    return false;
+  if(last > INDIRECT_CNT * INDIRECT_CNT)
+    last = INDIRECT_CNT * INDIRECT_CNT;
+
+  struct indirect double_indirect;
+  bool success = true;
+
+  if(!block_allocate (&disk_inode->double_indirect, &goal))
+    return false;
+  sector_read (disk_inode->double_indirect, &double_indirect);
+  for(size_t i = first / INDIRECT_CNT; i <= (last - 1) / INDIRECT_CNT && success; i++){
+    size_t from = i == first / INDIRECT_CNT ? first % INDIRECT_CNT : 0;
+    to = i == (last - 1) / INDIRECT_CNT ? (last - 1) % INDIRECT_CNT + 1 : INDIRECT_CNT;
+    success = indirect_block_allocate (&double_indirect.block[i], from, to, &goal);
+  }
+  /* double indirect block 저장 */
+  sector_write (disk_inode->double_indirect, &double_indirect);
+  return success;
+}
 
-    struct indirect single_indirect;	// single indirect block
-    block_read (fs_device, double_indirect.block[i], &single_indirect);
- 
-    /* data block free하고 disk에 write */  
-    for(int j=0; j < single_idx; j++)
-      free_map_release(single_indirect.block[j], 1);
-    /* single indirect block free하고 disk에 write */
-    free_map_release(double_indirect.block[i], 1);
-  } 
-  /* double indirect block free하고 disk에 write */
-  free_map_release(inode->data.double_indirect, 1);
+/* INODE에 할당된 모든 block free (hole은 건너뜀) */
+void inode_block_deallocate (struct inode *inode)
+{
+  /* direct block */
+  for(size_t i=0; i<DIRECT_CNT; i++)
+    if(inode->data.direct[i])
+      free_map_release (inode->data.direct[i], 1);
+
+  /* indirect block */
+  if(inode->data.indirect)
+    indirect_block_deallocate (inode->data.indirect);
+
+  /* double indirect block */
+  if(inode->data.double_indirect){
+    struct indirect double_indirect;
+    sector_read (inode->data.double_indirect, &double_indirect); 
+    for(size_t i=0; i<INDIRECT_CNT; i++)
+      if(double_indirect.block[i])
+        indirect_block_deallocate (double_indirect.block[i]);
+    free_map_release (inode->data.double_indirect, 1);
+  }
 }
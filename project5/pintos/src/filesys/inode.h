@@ -16,10 +16,13 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+void inode_read_ahead (struct inode *, off_t offset, int sector_cnt);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
 bool inode_is_dir (const struct inode *);
 bool inode_is_remove (const struct inode *);
+int inode_dir_index_bits (const struct inode *);
+void inode_set_dir_index_bits (struct inode *, int bits);
 
 #endif /* filesys/inode.h */
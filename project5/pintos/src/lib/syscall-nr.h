@@ -32,6 +32,15 @@ enum
     
     /* Project 2 additional */
     SYS_FIBO,
-    SYS_MAXOF4
+    SYS_MAXOF4,
+
+    /* Batched directory enumeration. */
+    SYS_GETDENTS,               /* Reads several directory entries. */
+
+    /* Positional and vectored I/O. */
+    SYS_PREAD,                  /* Read from a file at a given offset. */
+    SYS_PWRITE,                 /* Write to a file at a given offset. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV                  /* Write to a file from several buffers. */
   };
 #endif /* lib/syscall-nr.h */
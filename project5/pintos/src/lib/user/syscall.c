@@ -200,6 +200,36 @@ inumber (int fd)
   return syscall1 (SYS_INUMBER, fd);
 }
 
+int
+getdents (int fd, struct dirent *ents, unsigned cnt)
+{
+  return syscall3 (SYS_GETDENTS, fd, ents, cnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
 int 
 fibonacci (int n)
 {
@@ -15,6 +15,21 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* Directory entry written by getdents(). */
+struct dirent
+  {
+    int inumber;                        /* Inode number. */
+    bool is_dir;                        /* Directory or file? */
+    char name[READDIR_MAX_LEN + 1];     /* Null terminated file name. */
+  };
+
+/* Buffer for readv() and writev(). */
+struct iovec
+  {
+    void *iov_base;                     /* Start of buffer. */
+    unsigned iov_len;                   /* Size of buffer in bytes. */
+  };
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -44,6 +59,11 @@ bool mkdir (const char *dir);
 bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
+int getdents (int fd, struct dirent *, unsigned cnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
 
 /* Project 2 additional */
 int fibonacci (int n);
@@ -0,0 +1,147 @@
+/* Child process for syn-cache.
+
+   Child 0 reads "hotfile", which stays in the buffer cache, over
+   and over, and after each read stores the number of reads it has
+   completed in "syncfile".  It stops once child 1 is done.
+
+   Child 1 waits until child 0 is hitting, then reads every sector
+   of "coldfile" with pread() in random order, so that most reads
+   miss in the buffer cache.  Around each read it looks at child
+   0's count.  While child 1 waits for the disk, child 0 is the
+   only process that can run.  If the cache let hits proceed
+   during a miss, child 0's count advances during that read.  If
+   hits were serialized behind the miss, child 0 would be blocked
+   for the whole disk read and its count would stay the same.
+   Child 1 requires the count to advance during at least half of
+   its reads. */
+
+#include <random.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/filesys/extended/syn-cache.h"
+#include "tests/lib.h"
+
+static char cold_buf[COLD_SIZE];
+static char hot_buf[HOT_SIZE];
+static char read_buf[512];
+static int order[COLD_SECTORS];
+
+static char
+get_flag (int fd) 
+{
+  char flag;
+
+  CHECK (pread (fd, &flag, 1, FLAG_OFS) == 1, "read \"%s\"", sync_file_name);
+  return flag;
+}
+
+static void
+set_flag (int fd, char flag) 
+{
+  CHECK (pwrite (fd, &flag, 1, FLAG_OFS) == 1, "write \"%s\"", sync_file_name);
+}
+
+static int
+get_hits (int fd) 
+{
+  int hits;
+
+  CHECK (pread (fd, &hits, sizeof hits, HITS_OFS) == sizeof hits,
+         "read \"%s\"", sync_file_name);
+  return hits;
+}
+
+/* Reads "hotfile" until the miss child is done, publishing the
+   number of completed reads after each one. */
+static void
+hit (int sync_fd) 
+{
+  int fd;
+  int hits = 0;
+
+  CHECK ((fd = open (hot_file_name)) > 1, "open \"%s\"", hot_file_name);
+  set_flag (sync_fd, FLAG_HITTING);
+  do
+    {
+      CHECK (pread (fd, read_buf, HOT_SIZE, 0) == HOT_SIZE,
+             "read \"%s\"", hot_file_name);
+      compare_bytes (read_buf, hot_buf, HOT_SIZE, 0, hot_file_name);
+      hits++;
+      CHECK (pwrite (sync_fd, &hits, sizeof hits, HITS_OFS) == sizeof hits,
+             "write \"%s\"", sync_file_name);
+    }
+  while (get_flag (sync_fd) != FLAG_DONE);
+  close (fd);
+}
+
+/* Waits for the hit child to start, then reads the sectors of
+   "coldfile" in random order.  Returns the number of reads during
+   which the hit child completed at least one read. */
+static int
+miss (int sync_fd) 
+{
+  int fd;
+  int i, overlapped = 0;
+
+  for (i = 0; i < COLD_SECTORS; i++)
+    order[i] = i;
+  for (i = COLD_SECTORS - 1; i > 0; i--) 
+    {
+      int j = random_ulong () % (i + 1);
+      int tmp = order[i];
+      order[i] = order[j];
+      order[j] = tmp;
+    }
+
+  while (get_flag (sync_fd) != FLAG_HITTING)
+    continue;
+
+  CHECK ((fd = open (cold_file_name)) > 1, "open \"%s\"", cold_file_name);
+  for (i = 0; i < COLD_SECTORS; i++)
+    {
+      size_t ofs = order[i] * 512;
+      int before = get_hits (sync_fd);
+
+      CHECK (pread (fd, read_buf, 512, ofs) == 512,
+             "read 512 bytes at offset %zu in \"%s\"", ofs, cold_file_name);
+      if (get_hits (sync_fd) != before)
+        overlapped++;
+      compare_bytes (read_buf, cold_buf + ofs, 512, ofs, cold_file_name);
+    }
+  close (fd);
+
+  set_flag (sync_fd, FLAG_DONE);
+  return overlapped;
+}
+
+int
+main (int argc, const char *argv[]) 
+{
+  int child_idx;
+  int sync_fd;
+
+  test_name = "child-syn-cache";
+  quiet = true;
+  
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+
+  /* Same sequence as the parent, which created the files. */
+  random_init (0);
+  random_bytes (cold_buf, sizeof cold_buf);
+  random_bytes (hot_buf, sizeof hot_buf);
+
+  CHECK ((sync_fd = open (sync_file_name)) > 1, "open \"%s\"", sync_file_name);
+  if (child_idx == HIT_CHILD)
+    hit (sync_fd);
+  else 
+    {
+      int overlapped = miss (sync_fd);
+      CHECK (overlapped >= COLD_SECTORS / 2,
+             "hits on \"%s\" completed during only %d of %d reads of \"%s\"",
+             hot_file_name, overlapped, COLD_SECTORS, cold_file_name);
+    }
+  close (sync_fd);
+
+  return child_idx;
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+my ($cold) = random_bytes (256 * 512);
+my ($hot) = random_bytes (512);
+check_archive ({"child-syn-cache" => "tests/filesys/extended/child-syn-cache",
+		"coldfile" => [$cold], "hotfile" => [$hot]});
+pass;
@@ -0,0 +1,50 @@
+/* Has one subprocess read a cached file over and over while
+   another subprocess reads sectors that are not in the buffer
+   cache, so that the hits overlap with misses being filled from
+   disk.  Checks that each read returns the right data and that
+   the hits are not serialized behind the misses. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/filesys/extended/syn-cache.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 2
+
+static char cold_buf[COLD_SIZE];
+static char hot_buf[HOT_SIZE];
+static char sync_buf[SYNC_SIZE];
+
+static void
+create_file (const char *name, const void *buf, int size) 
+{
+  int fd;
+
+  CHECK (create (name, 0), "create \"%s\"", name);
+  CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+  CHECK (write (fd, buf, size) == size, "write \"%s\"", name);
+  close (fd);
+}
+
+void
+test_main (void) 
+{
+  pid_t children[CHILD_CNT];
+
+  random_bytes (cold_buf, sizeof cold_buf);
+  random_bytes (hot_buf, sizeof hot_buf);
+  memset (sync_buf, 0, sizeof sync_buf);
+  sync_buf[FLAG_OFS] = FLAG_IDLE;
+
+  create_file (cold_file_name, cold_buf, COLD_SIZE);
+  create_file (hot_file_name, hot_buf, HOT_SIZE);
+  create_file (sync_file_name, sync_buf, SYNC_SIZE);
+
+  exec_children ("child-syn-cache", children, CHILD_CNT);
+  wait_children (children, CHILD_CNT);
+
+  /* The hit count it holds varies from run to run. */
+  CHECK (remove (sync_file_name), "remove \"%s\"", sync_file_name);
+}
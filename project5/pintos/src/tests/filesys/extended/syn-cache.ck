@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(syn-cache) begin
+(syn-cache) create "coldfile"
+(syn-cache) open "coldfile"
+(syn-cache) write "coldfile"
+(syn-cache) create "hotfile"
+(syn-cache) open "hotfile"
+(syn-cache) write "hotfile"
+(syn-cache) create "syncfile"
+(syn-cache) open "syncfile"
+(syn-cache) write "syncfile"
+(syn-cache) exec child 1 of 2: "child-syn-cache 0"
+(syn-cache) exec child 2 of 2: "child-syn-cache 1"
+(syn-cache) wait for child 1 of 2 returned 0 (expected 0)
+(syn-cache) wait for child 2 of 2 returned 1 (expected 1)
+(syn-cache) remove "syncfile"
+(syn-cache) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+#ifndef TESTS_FILESYS_EXTENDED_SYN_CACHE_H
+#define TESTS_FILESYS_EXTENDED_SYN_CACHE_H
+
+/* "coldfile" is four times as large as the 64-sector buffer
+   cache, so at most a quarter of its sectors can be cached when
+   the miss child starts.  The miss child reads it with pread(),
+   which does no read-ahead, in random order.  "hotfile" is a
+   single sector that stays cached. */
+#define COLD_SECTORS 256
+#define COLD_SIZE (COLD_SECTORS * 512)
+#define HOT_SIZE 512
+static const char cold_file_name[] = "coldfile";
+static const char hot_file_name[] = "hotfile";
+
+/* "syncfile" lets the two children hand off to each other.  It
+   holds a flag byte at FLAG_OFS and, at HITS_OFS, the number of
+   reads of "hotfile" the hit child has completed so far. */
+static const char sync_file_name[] = "syncfile";
+#define FLAG_OFS 0
+#define HITS_OFS 4
+#define SYNC_SIZE 8
+
+/* Child indexes. */
+#define HIT_CHILD 0
+#define MISS_CHILD 1
+
+/* Values of the flag byte. */
+#define FLAG_IDLE 'i'           /* Neither child has started. */
+#define FLAG_HITTING 'h'        /* Hit child is reading "hotfile". */
+#define FLAG_DONE 'd'           /* Miss child read all of "coldfile". */
+
+#endif /* tests/filesys/extended/syn-cache.h */
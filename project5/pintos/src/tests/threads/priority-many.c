@@ -0,0 +1,144 @@
+/* Creates a few hundred threads spread over almost every
+   priority level, all below the main thread's priority, so they
+   pile up in the ready queue.  Each thread yields several times
+   before it finishes, exercising the scheduler's enqueue and
+   dequeue paths with a long run queue.  Once the main thread
+   lowers its priority, the threads must finish strictly in
+   descending order of priority.
+
+   Then checks that the cost of a yield does not grow with the
+   length of the run queue: the same number of yields must not
+   take much longer with 200 threads queued over 62 priorities
+   than with 4 threads queued at a single priority.  A scheduler
+   that scans or sorts the whole ready list on every yield takes
+   many times longer with the long queue.  The tick counts depend
+   on the machine, so the .ck file ignores them. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+struct many_thread_data 
+  {
+    int id;                     /* Thread ID. */
+    int priority;               /* Thread priority. */
+    int iter_cnt;               /* Number of times to yield. */
+    int **op;                   /* Output buffer position. */
+  };
+
+#define THREAD_CNT 200
+#define LEVEL_CNT (PRI_MAX - PRI_MIN - 1)
+#define ITER_CNT 8
+
+/* Timing runs: total number of yields, and the number of threads
+   in the run with the short run queue. */
+#define YIELD_CNT 100000
+#define SHORT_CNT 4
+
+/* Allowed slack for timer granularity, in ticks. */
+#define SLACK_TICKS (TIMER_FREQ / 10)
+
+static thread_func many_thread_func;
+static int64_t run_threads (int thread_cnt, int level_cnt, int iter_cnt);
+
+void
+test_priority_many (void) 
+{
+  int64_t short_ticks, long_ticks;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  msg ("%d threads at %d priorities will each yield %d times.",
+       THREAD_CNT, LEVEL_CNT, ITER_CNT);
+  msg ("Threads must finish in descending order of priority.");
+  run_threads (THREAD_CNT, LEVEL_CNT, ITER_CNT);
+  msg ("All %d threads finished in priority order.", THREAD_CNT);
+
+  msg ("Timing %d yields with short and long run queues.", YIELD_CNT);
+  short_ticks = run_threads (SHORT_CNT, 1, YIELD_CNT / SHORT_CNT);
+  msg ("%d threads at 1 priority: %d yields in %"PRId64" ticks.",
+       SHORT_CNT, YIELD_CNT, short_ticks);
+  long_ticks = run_threads (THREAD_CNT, LEVEL_CNT, YIELD_CNT / THREAD_CNT);
+  msg ("%d threads at %d priorities: %d yields in %"PRId64" ticks.",
+       THREAD_CNT, LEVEL_CNT, YIELD_CNT, long_ticks);
+  if (long_ticks > 2 * short_ticks + SLACK_TICKS)
+    fail ("yielding with %d queued threads took %"PRId64" ticks, "
+          "more than twice the %"PRId64" ticks with %d queued threads",
+          THREAD_CNT, long_ticks, short_ticks, SHORT_CNT);
+  msg ("Yield cost does not grow with the run queue.");
+}
+
+/* Creates THREAD_CNT threads spread over LEVEL_CNT priorities,
+   all below the main thread's priority, that each yield ITER_CNT
+   times.  Checks that they finish in descending order of
+   priority, and returns the number of ticks from when the main
+   thread lowered its priority until they all finished. */
+static int64_t
+run_threads (int thread_cnt, int level_cnt, int iter_cnt) 
+{
+  struct many_thread_data *data;
+  int *output, *op;
+  int i, cnt;
+  int64_t start, ticks;
+
+  data = malloc (sizeof *data * thread_cnt);
+  output = op = malloc (sizeof *output * thread_cnt);
+  ASSERT (data != NULL && output != NULL);
+
+  thread_set_priority (PRI_MAX);
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char name[16];
+      struct many_thread_data *d = data + i;
+      snprintf (name, sizeof name, "many %d", i);
+      d->id = i;
+      d->priority = PRI_MIN + 1 + i % level_cnt;
+      d->iter_cnt = iter_cnt;
+      d->op = &op;
+      if (thread_create (name, d->priority, many_thread_func, d) == TID_ERROR)
+        fail ("thread_create failed for thread %d", i);
+    }
+
+  start = timer_ticks ();
+  thread_set_priority (PRI_MIN);
+  /* All the other threads now run to termination here. */
+  ticks = timer_elapsed (start);
+  thread_set_priority (PRI_DEFAULT);
+
+  cnt = op - output;
+  if (cnt != thread_cnt)
+    fail ("%d threads finished, expected %d", cnt, thread_cnt);
+  for (i = 1; i < cnt; i++)
+    if (data[output[i]].priority > data[output[i - 1]].priority)
+      fail ("thread %d (priority %d) finished after thread %d (priority %d)",
+            output[i], data[output[i]].priority,
+            output[i - 1], data[output[i - 1]].priority);
+
+  free (output);
+  free (data);
+  return ticks;
+}
+
+static void 
+many_thread_func (void *data_) 
+{
+  struct many_thread_data *data = data_;
+  enum intr_level old_level;
+  int i;
+  
+  for (i = 0; i < data->iter_cnt; i++) 
+    thread_yield ();
+
+  old_level = intr_disable ();
+  *(*data->op)++ = data->id;
+  intr_set_level (old_level);
+}
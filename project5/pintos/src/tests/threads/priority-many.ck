@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Tick counts depend on the machine.
+s/ in \d+ ticks\.$/ in N ticks./ foreach @output;
+
+compare_output ("run", \@output, [<<'EOF']);
+(priority-many) begin
+(priority-many) 200 threads at 62 priorities will each yield 8 times.
+(priority-many) Threads must finish in descending order of priority.
+(priority-many) All 200 threads finished in priority order.
+(priority-many) Timing 100000 yields with short and long run queues.
+(priority-many) 4 threads at 1 priority: 100000 yields in N ticks.
+(priority-many) 200 threads at 62 priorities: 100000 yields in N ticks.
+(priority-many) Yield cost does not grow with the run queue.
+(priority-many) end
+EOF
+pass;
@@ -32,6 +32,7 @@ static const struct test tests[] =
     {"priority-sema", test_priority_sema},
     {"priority-aging", test_priority_aging},
     {"priority-condvar", test_priority_condvar},
+    {"priority-many", test_priority_many},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -36,6 +36,11 @@
 #include "devices/ide.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
+#include "filesys/buffer_cache.h"
+#endif
+#ifdef USERPROG
+#include "vm/frame.h"
+#include "vm/swap.h"
 #endif
 
 /* Page directory with kernel mappings only. */
@@ -89,7 +94,6 @@ main (void)
      then enable console locking. */
   thread_init ();
   console_init ();  
-  buffer_cache_init ();
 
   /* Greet user. */
   printf ("Pintos booting with %'"PRIu32" kB RAM...\n",
@@ -127,8 +131,11 @@ main (void)
   locate_block_devices ();
   filesys_init (format_filesys);
 #endif
-  sec_chance_init ();  
+#ifdef USERPROG
+  /* user page의 frame table과 swap table (lazy loading에 사용) */
+  sec_chance_init ();
   swap_init ();
+#endif
 
   printf ("Boot complete.\n");
   
@@ -250,6 +257,10 @@ parse_options (char **argv)
         filesys_bdev_name = value;
       else if (!strcmp (name, "-scratch"))
         scratch_bdev_name = value;
+      else if (!strcmp (name, "-wb-interval"))
+        buffer_cache_flush_interval = atoi (value);
+      else if (!strcmp (name, "-wb-dirty"))
+        buffer_cache_dirty_max = atoi (value);
 #ifdef VM
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
@@ -381,6 +392,8 @@ usage (void)
           "  -f                 Format file system device during startup.\n"
           "  -filesys=BDEV      Use BDEV for file system instead of default.\n"
           "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
+          "  -wb-interval=TICKS Write back dirty cache blocks every TICKS.\n"
+          "  -wb-dirty=COUNT    Write back early once COUNT blocks are dirty.\n"
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
@@ -32,6 +32,9 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/* Maximum length of a chain of nested priority donations. */
+#define DONATE_DEPTH_MAX 8
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -201,9 +204,53 @@ lock_init (struct lock *lock)
   ASSERT (lock != NULL);
 
   lock->holder = NULL;
+  lock->max_priority = PRI_MIN;
   sema_init (&lock->semaphore, 1);
 }
 
+/* Returns the highest priority among the threads waiting on
+   SEMA, or PRI_MIN if there are none. */
+static int
+sema_max_priority (struct semaphore *sema)
+{
+  int priority = PRI_MIN;
+  struct list_elem *e;
+
+  for (e = list_begin (&sema->waiters); e != list_end (&sema->waiters);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, elem);
+      if (t->priority > priority)
+        priority = t->priority;
+    }
+  return priority;
+}
+
+/* Donates the current thread's priority to the holder of LOCK,
+   which the current thread is about to wait for.  If that holder
+   is itself waiting for a lock, the donation is passed along the
+   chain (nested donation), up to DONATE_DEPTH_MAX locks deep.
+   Must be called with interrupts off. */
+static void
+donate_priority (struct lock *lock)
+{
+  int priority = thread_current ()->priority;
+  int depth;
+
+  for (depth = 0; lock != NULL && lock->holder != NULL
+                  && depth < DONATE_DEPTH_MAX; depth++)
+    {
+      struct thread *holder = lock->holder;
+
+      if (lock->max_priority < priority)
+        lock->max_priority = priority;
+      if (holder->priority >= priority)
+        break;
+      thread_update_priority (holder, priority);
+      lock = holder->wait_on_lock;
+    }
+}
+
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
@@ -219,8 +266,27 @@ lock_acquire (struct lock *lock)
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  struct thread *cur = thread_current ();
+  enum intr_level old_level = intr_disable ();
+
+  /* Lend our priority to the holder so that it cannot be held up
+     by threads of intermediate priority while we wait. */
+  if (!thread_mlfqs && lock->holder != NULL)
+    {
+      cur->wait_on_lock = lock;
+      donate_priority (lock);
+    }
+
   sema_down (&lock->semaphore);
-  lock->holder = thread_current ();
+  cur->wait_on_lock = NULL;
+  lock->holder = cur;
+
+  /* Threads still waiting now donate to us instead. */
+  list_push_back (&cur->locks, &lock->elem);
+  lock->max_priority = sema_max_priority (&lock->semaphore);
+  if (!thread_mlfqs)
+    thread_refresh_priority (cur);
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -237,9 +303,19 @@ lock_try_acquire (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  enum intr_level old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      list_push_back (&lock->holder->locks, &lock->elem);
+      /* Threads already queued on the semaphore donate to us, as
+         in lock_acquire(). */
+      lock->max_priority = sema_max_priority (&lock->semaphore);
+      if (!thread_mlfqs)
+        thread_refresh_priority (lock->holder);
+    }
+  intr_set_level (old_level);
   return success;
 }
 
@@ -254,8 +330,17 @@ lock_release (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  enum intr_level old_level = intr_disable ();
+
+  /* Give back the priority donated through LOCK. */
+  list_remove (&lock->elem);
   lock->holder = NULL;
+  if (!thread_mlfqs)
+    thread_refresh_priority (thread_current ());
+
   sema_up (&lock->semaphore);
+  thread_preempt ();
+  intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -359,3 +444,83 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW, a readers-writer lock.  Any number of readers
+   may hold RW at once, or a single writer may hold it
+   exclusively.  Waiting writers are preferred over new readers,
+   so that a steady stream of readers cannot starve a writer.
+
+   Unlike a lock, RW has no owner, so it is not checked that the
+   releasing thread is the one that acquired it. */
+void
+rw_lock_init (struct rw_lock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  cond_init (&rw->readers);
+  cond_init (&rw->writers);
+  rw->reader_cnt = 0;
+  rw->waiting_writers = 0;
+  rw->writer = false;
+}
+
+/* Acquires RW for shared access, sleeping while a writer holds
+   or is waiting for it. */
+void
+rw_lock_acquire_read (struct rw_lock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  while (rw->writer || rw->waiting_writers > 0)
+    cond_wait (&rw->readers, &rw->lock);
+  rw->reader_cnt++;
+  lock_release (&rw->lock);
+}
+
+/* Releases shared access to RW. */
+void
+rw_lock_release_read (struct rw_lock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->reader_cnt > 0);
+  if (--rw->reader_cnt == 0)
+    cond_signal (&rw->writers, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Acquires RW for exclusive access, sleeping until all readers
+   and any other writer have released it. */
+void
+rw_lock_acquire_write (struct rw_lock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  rw->waiting_writers++;
+  while (rw->writer || rw->reader_cnt > 0)
+    cond_wait (&rw->writers, &rw->lock);
+  rw->waiting_writers--;
+  rw->writer = true;
+  lock_release (&rw->lock);
+}
+
+/* Releases exclusive access to RW, waking a waiting writer if
+   there is one and otherwise all waiting readers. */
+void
+rw_lock_release_write (struct rw_lock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->writer);
+  rw->writer = false;
+  if (rw->waiting_writers > 0)
+    cond_signal (&rw->writers, &rw->lock);
+  else
+    cond_broadcast (&rw->readers, &rw->lock);
+  lock_release (&rw->lock);
+}
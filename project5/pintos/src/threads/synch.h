@@ -22,6 +22,8 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct list_elem elem;      /* Element in holder's list of held locks. */
+    int max_priority;           /* Highest priority among waiters. */
   };
 
 void lock_init (struct lock *);
@@ -41,6 +43,23 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock. */
+struct rw_lock
+  {
+    struct lock lock;           /* Protects the members below. */
+    struct condition readers;   /* Signaled when readers may enter. */
+    struct condition writers;   /* Signaled when a writer may enter. */
+    int reader_cnt;             /* Number of threads holding it shared. */
+    int waiting_writers;        /* Number of writers waiting to enter. */
+    bool writer;                /* True if held exclusively. */
+  };
+
+void rw_lock_init (struct rw_lock *);
+void rw_lock_acquire_read (struct rw_lock *);
+void rw_lock_release_read (struct rw_lock *);
+void rw_lock_acquire_write (struct rw_lock *);
+void rw_lock_release_write (struct rw_lock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
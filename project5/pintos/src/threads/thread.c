@@ -14,6 +14,9 @@
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
+#ifdef FILESYS
+#include "filesys/directory.h"
+#endif
 #include "devices/timer.h"
 #include "threads/fixed-point-arithmetic.h"
 
@@ -23,17 +26,35 @@
 #define THREAD_MAGIC 0xcd6abf4b
 
 int load_avg;
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* List of processes in THREAD_BLOCK state */
-static struct list block_list;	// block된 thread를 관리하기 위한 list 
+/* Lists of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.  One FIFO list
+   per priority; bit P of ready_mask is set iff ready_list[P] is
+   nonempty. */
+static struct list ready_list[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt;		// ready list에 있는 thread 수
+
+/* MLFQS에서 recent_cpu, priority를 다시 계산해야 하는 thread들
+   recent_cpu와 nice가 모두 0인 thread는 매 초 decay해도 값이 바뀌지 않으므로 제외 */
+static struct list mlfqs_list;	// nice 또는 recent_cpu가 0이 아닌 thread
+static struct list dirty_list;	// 마지막 priority 계산 이후 recent_cpu나 nice가 바뀐 thread
+
+/* sleep 중인 thread를 wakeup_time 기준 min-heap (pairing heap)으로 관리
+   thread의 sleep_child, sleep_sibling을 사용하므로 추가 memory 할당 없음
+   삽입 O(1), 가장 이른 thread 제거는 amortized O(log n) */
+static struct thread *sleep_heap;	// wakeup_time이 가장 이른 thread (heap의 root), 비어있으면 NULL
+static uint64_t sleep_seq;	// 같은 wakeup_time이면 먼저 잠든 thread부터 깨우기 위한 순번
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
+/* 종료된 thread의 page를 다음 thread_create()에서 재사용하기 위한 cache
+   page의 앞부분을 list_elem으로 사용 */
+#define THREAD_CACHE_MAX 8
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+
 /* Idle thread. */
 static struct thread *idle_thread;
 
@@ -80,6 +101,12 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static int ready_max_priority (void);
+static void ready_remove (struct thread *t);
+static void mlfqs_touch (struct thread *t);
+static struct thread *thread_alloc_page (void);
+static void thread_free_page (struct thread *t);
+static int mlfqs_priority (struct thread *t);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -100,9 +127,17 @@ thread_init (void)
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
-  list_init (&block_list);	// block list
+  for (int i = PRI_MIN; i <= PRI_MAX; i++)
+    list_init (&ready_list[i]);
+  ready_mask = 0;
+  ready_cnt = 0;
+  list_init (&mlfqs_list);
+  list_init (&dirty_list);
+  sleep_heap = NULL;	// sleep heap
+  sleep_seq = 0;
   list_init (&all_list);
+  list_init (&thread_cache);
+  thread_cache_cnt = 0;
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -200,7 +235,7 @@ thread_create (const char *name, int priority,
   ASSERT (function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  t = thread_alloc_page ();
   if (t == NULL)
     return TID_ERROR;
 
@@ -217,17 +252,24 @@ thread_create (const char *name, int priority,
   sema_init(&t->child_process_exit, 0);
   /* load semaphore 0으로 init */
   sema_init(&t->new_process_load, 0);
+#ifdef USERPROG
   /* parent process의 child list에 추가 */
   list_push_back(&t->par->children, &t->child);
+#else
+  /* process_wait()이 없으므로 child list에 넣지 않고, 종료되면 바로 page free */
+  t->reaped = true;
+#endif
 
   tid = t->tid = allocate_tid ();
   
-  /* file descriptor table init */
+#ifdef USERPROG
+  /* file descriptor table init (process_exit()에서 free) */
   for (int i=0; i<128; i++){
     t->file_desc[i] = (struct file_desc *)malloc (sizeof (struct file_desc));
     t->file_desc[i]->f = NULL;
     t->file_desc[i]->d = NULL;
   }
+#endif
 
   /* 
     Project3: parent의 nice, recent_cpu값 inherit 
@@ -237,10 +279,19 @@ thread_create (const char *name, int priority,
     t->nice = t->par->nice;
     t->recent_cpu = t->par->recent_cpu;
 
+#ifdef FILESYS
     if (t->par->cur_dir != NULL)
       t->cur_dir = dir_reopen (t->par->cur_dir); // parent의 cwd inherit
     else
+#endif
       t->cur_dir = NULL; //dir_open_root ();
+
+    /* 상속받은 recent_cpu나 nice가 0이 아니면 매 초 decay 대상에 포함 */
+    if(thread_mlfqs && (t->nice != 0 || t->recent_cpu != 0)){
+      enum intr_level old_level = intr_disable ();
+      mlfqs_touch (t);
+      intr_set_level (old_level);
+    }
   }
 
   /* Stack frame for kernel_thread(). */
@@ -359,6 +410,10 @@ thread_exit (void)
      when it calls thread_schedule_tail(). */
   intr_disable ();
   list_remove (&thread_current()->allelem);
+  if (thread_current ()->mlfqs_active)
+    list_remove (&thread_current ()->mlfqs_elem);
+  if (thread_current ()->mlfqs_dirty)
+    list_remove (&thread_current ()->dirty_elem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -410,14 +465,15 @@ thread_set_priority (int new_priority)
     return;
 
   struct thread *cur = thread_current();
-  /* current thread의 priority 변경  */
-  int cur_priority = cur->priority;
-  cur->priority = new_priority;
+  enum intr_level old_level = intr_disable ();
+  /* current thread의 base priority 변경
+     donation받은 priority가 더 높다면 lock을 release할 때까지 유지 */
+  cur->base_priority = new_priority;
+  thread_refresh_priority (cur);
+  intr_set_level (old_level);
   /* 변경한 thread의 priority가 더 작아진 경우 
      ready list의 thread와 비교하여 우선순위가 높은 thread 실행 */ 
-  if(cur_priority > new_priority){
-    thread_yield();
-  }
+  thread_preempt ();
 }
 
 /* Returns the current thread's priority. */
@@ -431,16 +487,15 @@ thread_get_priority (void)
 void
 thread_set_nice (int nice UNUSED) 
 {
+  enum intr_level old_level = intr_disable ();
   /* current thread의 nice값 변경 */
   thread_current ()->nice = nice;
+  mlfqs_touch (thread_current ());
   int cur_priority = thread_current ()->priority; // thread의 기존 priority
-  int new_priority = PRI_MAX - fp_to_int_round_near(thread_current ()->recent_cpu >> 2) - (nice * 2); // thread의 변경된 priority
-  if(new_priority > PRI_MAX)
-    new_priority = PRI_MAX;
-  if(new_priority < PRI_MIN)
-    new_priority = PRI_MIN;
+  int new_priority = mlfqs_priority (thread_current ()); // thread의 변경된 priority
 
-  thread_current ()->priority = new_priority;
+  thread_update_priority (thread_current (), new_priority);
+  intr_set_level (old_level);
   /* 변경된 thread의 priority가 더 작아진 경우 thread_yield() 호출 */
   if(new_priority < cur_priority)
     thread_yield();
@@ -467,6 +522,65 @@ thread_get_recent_cpu (void)
   return fp_to_int_round_near(prod_int_fp(100, thread_current ()->recent_cpu));
 }
 
+/* A가 B보다 먼저 깨어나야 하면 true (wakeup_time, 같으면 잠든 순서) */
+static bool sleep_before (const struct thread *a, const struct thread *b){
+  if(a->wakeup_time != b->wakeup_time)
+    return a->wakeup_time < b->wakeup_time;
+  return a->sleep_seq < b->sleep_seq;
+}
+
+/* root가 A, B인 두 heap을 합쳐 새로운 root return
+   늦게 깨어나는 root가 다른 root의 첫 번째 child가 됨 */
+static struct thread *sleep_meld (struct thread *a, struct thread *b){
+  if(a == NULL)
+    return b;
+  if(b == NULL)
+    return a;
+  if(sleep_before (b, a)){
+    struct thread *tmp = a;
+    a = b;
+    b = tmp;
+  }
+  b->sleep_sibling = a->sleep_child;
+  a->sleep_child = b;
+  return a;
+}
+
+/* sleep heap의 root를 제거하고 return (two-pass pairing)
+   child들을 앞에서부터 두 개씩 합친 뒤, 합친 결과를 뒤에서부터 하나로 합침 */
+static struct thread *sleep_pop (void){
+  struct thread *root = sleep_heap;
+  struct thread *pairs = NULL;
+  struct thread *c = root->sleep_child;
+
+  while(c != NULL){
+    struct thread *a = c;
+    struct thread *b = c->sleep_sibling;
+    struct thread *merged;
+    if(b == NULL){
+      c = NULL;
+      merged = a;
+    }
+    else{
+      c = b->sleep_sibling;
+      a->sleep_sibling = b->sleep_sibling = NULL;
+      merged = sleep_meld (a, b);
+    }
+    /* pairs에는 역순으로 쌓이므로 다음 loop는 뒤의 pair부터 합침 */
+    merged->sleep_sibling = pairs;
+    pairs = merged;
+  }
+
+  sleep_heap = NULL;
+  while(pairs != NULL){
+    struct thread *next = pairs->sleep_sibling;
+    pairs->sleep_sibling = NULL;
+    sleep_heap = sleep_meld (sleep_heap, pairs);
+    pairs = next;
+  }
+  return root;
+}
+
 /* Running thread를 parameter인 ticks까지 sleep시키는 함수 */
 void thread_sleep (int64_t ticks){
   struct thread *cur = thread_current ();
@@ -475,59 +589,146 @@ void thread_sleep (int64_t ticks){
   old_level = intr_disable ();
   if(cur != idle_thread){
     cur->wakeup_time = ticks;
-    /* block queue에 추가 */
-    list_push_back (&block_list, &cur->elem);
+    cur->sleep_seq = sleep_seq++;
+    cur->sleep_child = cur->sleep_sibling = NULL;
+    /* sleep heap에 O(1)로 추가 */
+    sleep_heap = sleep_meld (sleep_heap, cur);
     thread_block ();
   }
   intr_set_level (old_level);
 }
 
+/* 매 timer tick마다 호출, wakeup_time이 된 thread 깨우기
+   깨울 thread가 없으면 O(1), k개를 깨우면 amortized O(k log n) */
 void thread_wakeup (int64_t ticks){
-  /* block list 순회하여 wake up할 thread 찾아 꺠우기 */
-  struct list_elem *e = list_begin (&block_list);
-  while(e != list_end (&block_list)){
-    struct thread *t = list_entry (e, struct thread, elem);
-    /* thread wake up */
-    if(t->wakeup_time <= ticks){
-      /* ready list에 thread 추가하고, block list에서 제거 */
-      e = list_remove (e);
-      thread_unblock(t);
-    }
-    else
-      e = list_next (e); 
+  /* root가 가장 이른 thread이므로 root의 wakeup_time이 지난 동안만 꺼내서 깨우기 */
+  while(sleep_heap != NULL && sleep_heap->wakeup_time <= ticks)
+    thread_unblock (sleep_pop ());
+}
+
+/* thread를 priority에 해당하는 ready list의 뒤에 삽입, O(1)
+   같은 priority의 thread끼리는 FIFO 순서로 실행됨 */
+void thread_push_priority_order (struct thread *t){
+  list_push_back (&ready_list[t->priority], &t->elem);
+  ready_mask |= 1ULL << t->priority;
+  ready_cnt++;
+}
+
+/* ready list에서 thread 제거, list가 비면 ready_mask의 bit도 지움 */
+static void ready_remove (struct thread *t){
+  list_remove (&t->elem);
+  ready_cnt--;
+  if (list_empty (&ready_list[t->priority]))
+    ready_mask &= ~(1ULL << t->priority);
+}
+
+/* 비어있지 않은 ready list 중 가장 높은 priority, 모두 비어있으면 -1 */
+static int ready_max_priority (void){
+  uint32_t hi = ready_mask >> 32;
+  uint32_t lo = (uint32_t) ready_mask;
+
+  if (hi != 0)
+    return 63 - __builtin_clz (hi);
+  if (lo != 0)
+    return 31 - __builtin_clz (lo);
+  return -1;
+}
+
+/* thread T의 priority를 PRIORITY로 변경
+   T가 ready 상태라면 새 priority의 ready list로 옮김 */
+void thread_update_priority (struct thread *t, int priority){
+  enum intr_level old_level = intr_disable ();
+
+  if (t->status == THREAD_READY && t->priority != priority){
+    ready_remove (t);
+    t->priority = priority;
+    thread_push_priority_order (t);
   }
+  else
+    t->priority = priority;
 
+  intr_set_level (old_level);
 }
 
-void thread_push_priority_order (struct thread *t){
+/* T의 priority를 base priority와 T가 가진 lock을 기다리는 thread들의 priority 중
+   최댓값으로 재계산 (priority donation) */
+void thread_refresh_priority (struct thread *t){
+  int priority = t->base_priority;
   struct list_elem *e;
-  struct thread *tmp;
-  /* list가 비어있는 경우 가장 앞에 삽입 */
-  if(list_empty (&ready_list))
-    list_push_front (&ready_list, &t->elem);
-  else {
-    /* ready list 탐색하여 thread의 priority가 descending order로 정렬되도록 삽입 */
-    for (e = list_begin (&ready_list) ; e != list_end (&ready_list); e = list_next (e)){
-      tmp = list_entry (e, struct thread, elem);
-      /* thread 삽입할 위치 찾은 경우 탐색 종료 */
-      if(t->priority > tmp->priority){
-        break;
-      }
-    }
-    /* 찾은 위치에 thread 삽입 */
-    list_insert (e, &t->elem);
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (e = list_begin (&t->locks); e != list_end (&t->locks); e = list_next (e)){
+    struct lock *l = list_entry (e, struct lock, elem);
+    if (l->max_priority > priority)
+      priority = l->max_priority;
   }
+  thread_update_priority (t, priority);
+}
+
+/* ready list에 running thread보다 priority가 높은 thread가 있으면 yield */
+void thread_preempt (void){
+  if (!intr_context () && ready_max_priority () > thread_current ()->priority)
+    thread_yield ();
+}
+
+/* thread page 할당, cache에 page가 있으면 재사용 */
+static struct thread *thread_alloc_page (void){
+  struct list_elem *e = NULL;
+  enum intr_level old_level = intr_disable ();
+
+  if (!list_empty (&thread_cache)){
+    e = list_pop_front (&thread_cache);
+    thread_cache_cnt--;
+  }
+  intr_set_level (old_level);
+
+  if (e == NULL)
+    return palloc_get_page (PAL_ZERO);
+  memset (e, 0, PGSIZE);
+  return (struct thread *) e;
+}
+
+/* 종료된 thread T의 page free, cache에 여유가 있으면 cache에 보관 */
+static void thread_free_page (struct thread *t){
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t != initial_thread);
+
+  if (thread_cache_cnt < THREAD_CACHE_MAX){
+    list_push_front (&thread_cache, (struct list_elem *) t);
+    thread_cache_cnt++;
+  }
+  else
+    palloc_free_page (t);
+}
+
+/* parent가 CHILD를 더 이상 wait하지 않음 (wait 완료 또는 parent 종료)
+   CHILD가 이미 종료되었다면 page free, 아니면 종료될 때 스스로 free */
+void thread_reap (struct thread *child){
+  enum intr_level old_level = intr_disable ();
+
+  child->par = NULL;
+  child->reaped = true;
+  if (child->is_exit)
+    thread_free_page (child);
+  intr_set_level (old_level);
 }
 
 /* ready list에 있는 thread들의 priority 증가 시킴 */
 void thread_aging (void){
   struct list_elem *e;
+  int i;
   /* ready list를 순환하면서 list에 있는 모든 thread의 priority 증가 시킴 */
-  for(e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e)){
-    struct thread *t = list_entry (e, struct thread, elem);
-    if(t->priority < PRI_MAX)
-      t->priority++;
-  }
+  for (i = PRI_MIN; i < PRI_MAX; i++)
+    for (e = list_begin (&ready_list[i]); e != list_end (&ready_list[i]); e = list_next (e))
+      list_entry (e, struct thread, elem)->priority++;
+
+  /* 각 ready list를 한 칸 위의 priority로 옮김
+     PRI_MAX - 1의 thread는 PRI_MAX의 thread 뒤에 붙음 */
+  for (i = PRI_MAX; i > PRI_MIN; i--)
+    list_splice (list_end (&ready_list[i]), list_begin (&ready_list[i - 1]),
+                 list_end (&ready_list[i - 1]));
+  ready_mask = (ready_mask << 1) | (ready_mask & (1ULL << PRI_MAX));
 }
 
 /* load_avg update */
@@ -537,10 +738,8 @@ void recalculate_load_avg (void){
   if(thread_current () != idle_thread)
     ready_threads++;
 
-  struct list_elem *e;
-  /* ready state thread의 개수 counting */
-  for(e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e))
-    ready_threads++;
+  /* ready state thread의 개수 */
+  ready_threads += ready_cnt;
 
   load_avg = prod_fp_fp(div_fp_fp(int_to_fp(59), int_to_fp(60)), load_avg);
   load_avg = sum_fp_fp(load_avg, prod_fp_fp(div_fp_fp(int_to_fp(1), int_to_fp(60)), int_to_fp(ready_threads)));
@@ -550,10 +749,35 @@ void recalculate_load_avg (void){
     load_avg = 0;
 }
 
+/* T의 recent_cpu나 nice가 바뀌었으므로 다음 priority 계산 대상에 포함
+   interrupt를 끈 상태에서 호출 */
+static void mlfqs_touch (struct thread *t){
+  if(!t->mlfqs_active){
+    t->mlfqs_active = true;
+    list_push_back (&mlfqs_list, &t->mlfqs_elem);
+  }
+  if(!t->mlfqs_dirty){
+    t->mlfqs_dirty = true;
+    list_push_back (&dirty_list, &t->dirty_elem);
+  }
+}
+
+/* T의 recent_cpu와 nice로 계산한 MLFQS priority */
+static int mlfqs_priority (struct thread *t){
+  int priority = PRI_MAX - fp_to_int_round_near(t->recent_cpu >> 2) - (t->nice * 2);
+  if(priority > PRI_MAX)
+    priority = PRI_MAX;
+  else if(priority < PRI_MIN)
+    priority = PRI_MIN;
+  return priority;
+}
+
 /* recalculate recent_cpu every sec */
 void recalculate_recent_cpu (void){
-  if(thread_current () != idle_thread)
+  if(thread_current () != idle_thread){
     thread_current ()->recent_cpu = sum_int_fp(1, thread_current ()->recent_cpu);
+    mlfqs_touch (thread_current ());
+  }
 
   /* TIMER FREQ마다 recent_cpu 값 재조정 */
   if (timer_ticks () % TIMER_FREQ != 0)
@@ -565,52 +789,41 @@ void recalculate_recent_cpu (void){
 
   int tmp = prod_int_fp(2, load_avg);
   int v = div_fp_fp(tmp, sum_int_fp(1, tmp));
-  /* 모든 thread의 recent_cpu 값 재조정 */
-  for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)){
-    struct thread *t = list_entry (e, struct thread, allelem);
-    t->recent_cpu = sum_int_fp(t->nice, prod_fp_fp(v, t->recent_cpu));    
+  /* recent_cpu 또는 nice가 0이 아닌 thread의 recent_cpu 값 재조정
+     (둘 다 0인 thread는 decay해도 0이므로 제외) */
+  e = list_begin (&mlfqs_list);
+  while (e != list_end (&mlfqs_list)){
+    struct thread *t = list_entry (e, struct thread, mlfqs_elem);
+    t->recent_cpu = sum_int_fp(t->nice, prod_fp_fp(v, t->recent_cpu));
+    if(!t->mlfqs_dirty){
+      t->mlfqs_dirty = true;
+      list_push_back (&dirty_list, &t->dirty_elem);
+    }
+    /* recent_cpu가 0으로 decay된 thread는 다시 실행되거나 nice가 바뀔 때까지 제외 */
+    if(t->recent_cpu == 0 && t->nice == 0){
+      t->mlfqs_active = false;
+      e = list_remove (e);
+    }
+    else
+      e = list_next (e);
   }
 }
 
 /* recalculate priority every 4 ticks */
 void recalculate_priority (void){
-  struct list_elem *e;
-
   /* TIME_SLCIE 마다 priority 재조정 */
   if (timer_ticks () % TIME_SLICE != 0) 
      return;
 
-  /* 모든 thread의 priority를 재조정 */
-  for(e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)){
-    struct thread *t = list_entry (e, struct thread, allelem);
-    t->priority = PRI_MAX - fp_to_int_round_near(t->recent_cpu >> 2) - (t->nice * 2);
-    if(t->priority > PRI_MAX)
-      t->priority = PRI_MAX;
-    else if(t->priority < PRI_MIN)
-      t->priority = PRI_MIN;      
+  /* recent_cpu나 nice가 바뀐 thread의 priority만 재조정
+     ready 상태의 thread는 새 priority의 ready list로 옮겨짐 */
+  while(!list_empty (&dirty_list)){
+    struct thread *t = list_entry (list_pop_front (&dirty_list), struct thread, dirty_elem);
+    t->mlfqs_dirty = false;
+    thread_update_priority (t, mlfqs_priority (t));
   }
-
-  /* ready list를 다시 priority order로 재조정 */
-  reorder_ready_list();
 }
 
-/* ready_list를 priority order로 재조정 */
-void reorder_ready_list (void){
-  struct list tmp;
-  
-  /* ready list의 모든 thread를 제거하고, 임시 list에 저장 */
-  list_init(&tmp); 
-  while(!list_empty(&ready_list)){
-    list_push_back(&tmp, list_pop_front(&ready_list));
-  }
-  /* 임시 list의 모든 thread를 제거하고, 
-     ready list에 priority order로 삽입 */
-  while(!list_empty(&tmp)){
-    struct list_elem *e = list_pop_front(&tmp);
-    thread_push_priority_order(list_entry(e, struct thread, elem)); 
-  }
-}
-
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
@@ -697,10 +910,19 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+  t->base_priority = priority;
+  list_init (&t->locks);
+  t->wait_on_lock = NULL;
   t->magic = THREAD_MAGIC;
 
   old_level = intr_disable ();
   list_push_back (&all_list, &t->allelem);
+  /* MLFQS: 처음 priority 계산 시점까지는 PRIORITY 사용 */
+  if (thread_mlfqs)
+    {
+      t->mlfqs_dirty = true;
+      list_push_back (&dirty_list, &t->dirty_elem);
+    }
   intr_set_level (old_level);
 
   /* 자식 리스트 초기화 */
@@ -740,10 +962,17 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  int priority = ready_max_priority ();
+
+  if (priority < 0)
     return idle_thread;
   else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+    {
+      struct thread *t = list_entry (list_front (&ready_list[priority]),
+                                     struct thread, elem);
+      ready_remove (t);
+      return t;
+    }
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -788,7 +1017,11 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
     {
       ASSERT (prev != cur);
-//      palloc_free_page (prev);
+      /* parent가 이미 wait했거나 wait하지 않을 경우에만 free,
+         아니면 parent가 thread_reap()에서 free */
+      prev->is_exit = true;
+      if (prev->reaped)
+        thread_free_page (prev);
     }
 }
 
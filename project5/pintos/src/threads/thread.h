@@ -100,9 +100,14 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Priority, including donations. */
     struct list_elem allelem;           /* List element for all threads list. */
 
+    /* Priority donation, shared between thread.c and synch.c. */
+    int base_priority;                  /* Priority before donations. */
+    struct list locks;                  /* Locks held by this thread. */
+    struct lock *wait_on_lock;          /* Lock this thread is waiting for. */
+
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
 
@@ -112,7 +117,8 @@ struct thread
 #endif
     /* Plus */
     bool load_success;                  /* process의 생성 성공 여부 */
-    bool is_exit;                       /* process의 종료 여부 */
+    bool is_exit;                       /* process의 종료 여부 (더 이상 page를 사용하지 않음) */
+    bool reaped;                        /* parent가 더 이상 wait하지 않음, 종료되면 page free */
     struct thread* par;                 /* parent process descriptor */
     struct list_elem child;             /* child process list element */
     struct list children;               /* child process list */
@@ -128,11 +134,21 @@ struct thread
 
     /* Project3 */
     int64_t wakeup_time;
+    uint64_t sleep_seq;                 /* 같은 wakeup_time끼리 잠든 순서 */
+    struct thread *sleep_child;         /* sleep heap에서 첫 번째 child */
+    struct thread *sleep_sibling;       /* sleep heap에서 다음 sibling */
     int nice;
     int recent_cpu;
+    struct list_elem mlfqs_elem;        /* mlfqs_list element, nice 또는 recent_cpu가 0이 아닌 thread */
+    bool mlfqs_active;                  /* mlfqs_list에 있는지 여부 */
+    struct list_elem dirty_elem;        /* dirty_list element, priority 재계산이 필요한 thread */
+    bool mlfqs_dirty;                   /* dirty_list에 있는지 여부 */
 
     /* Project4 */
     struct hash spt;
+    struct list mmap_list;              /* mmap()으로 mapping된 file list */
+    int mapid_cnt;                      /* 다음 mmap()에 할당할 mapid */
+    struct file *exec_file;             /* demand paging할 executable file */
     
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
@@ -178,9 +194,12 @@ int thread_get_load_avg (void);
 void thread_sleep (int64_t ticks);
 void thread_wakeup (int64_t ticks);
 void thread_push_priority_order (struct thread *t);
+void thread_update_priority (struct thread *t, int priority);
+void thread_refresh_priority (struct thread *t);
+void thread_preempt (void);
+void thread_reap (struct thread *child);
 void thread_aging (void);
 void recalculate_load_avg (void);
 void recalculate_recent_cpu (void);
 void recalculate_priority (void);
-void reorder_ready_list (void); 
 #endif /* threads/thread.h */
@@ -81,6 +81,8 @@ start_process (void *file_name_)
   struct thread *cur = thread_current ();
 
   sp_init (&cur->spt);
+  list_init (&cur->mmap_list);
+  cur->mapid_cnt = 0;
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
@@ -129,7 +131,7 @@ process_wait (tid_t child_tid UNUSED)
     sema_down(&child->child_process_exit);
     exit_status = child->exit_status;
     list_remove(&child->child); // child process의 list 제거
-    palloc_free_page(child);	// child process에 할당된 page free
+    thread_reap(child);		// child process에 할당된 page free
   }
   return exit_status;
 }
@@ -149,17 +151,23 @@ process_exit (void)
     close (i);
     free (cur->file_desc[i]);
   }
+  free (cur->file_desc[0]);
+  free (cur->file_desc[1]);
   dir_close (cur->cur_dir);
 
-  /* child list element 제거 */
+  /* child list element 제거, wait하지 않은 child process의 page free */
   while(!list_empty(&cur->children))
-    list_pop_front(&cur->children);
-
-  sp_destroy (&cur->spt);
+    thread_reap(list_entry(list_pop_front(&cur->children), struct thread, child));
 
   pd = cur->pagedir;
   if (pd != NULL) 
     {
+      /* mapping된 file에 수정된 page write back 후, supplement page 정리 */
+      mmap_unmap_all ();
+      sp_destroy (&cur->spt);
+      file_close (cur->exec_file);
+      cur->exec_file = NULL;
+
       /* Correct ordering here is crucial.  We must set
          cur->pagedir to NULL before switching page directories,
          so that a timer interrupt can't switch back to the
@@ -399,6 +407,11 @@ load (const char *file_name, void (**eip) (void), void **esp)
   /* Start address. */
   *eip = (void (*) (void)) ehdr.e_entry;
 
+  /* code, data page는 실행 중에 file에서 load하므로 process 종료 시까지 열어둠
+     실행 중에는 executable file에 write 불가 */
+  file_deny_write (file);
+  t->exec_file = file;
+  file = NULL;
   success = true;
   palloc_free_page(argv);
 
@@ -411,6 +424,8 @@ load (const char *file_name, void (**eip) (void), void **esp)
 /* load() helpers. */
 
 static bool install_page (void *upage, void *kpage, bool writable);
+bool stack_growth (void *addr);
+static void swap_readahead (size_t slot);
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -465,8 +480,11 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
         - ZERO_BYTES bytes at UPAGE + READ_BYTES must be zeroed.
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
+   Pages are only recorded in the supplemental page table here;
+   each one is read from FILE by handle_mm_fault() the first time
+   it is touched.
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. */
+   occurs or a page is already mapped. */
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
@@ -475,7 +493,6 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
-  file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
       /* Calculate how to fill this page.
@@ -484,48 +501,31 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-      /* Get a page of memory. */
-      uint8_t *kpage = palloc_get_page (PAL_USER);
-      if (kpage == NULL){
-	/* memory 부족한 경우 frame evict */
-        evict_frame ();
-	kpage = palloc_get_page (PAL_USER);
-	if (kpage == NULL){
-          return false;
-	}
-      }
-
-      /* Load this page. */
-      if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes)
+      /* Project 4 */
+      /* page를 바로 load하지 않고, file의 어느 부분을 읽을지만 supplement page에 저장 */
+      struct supplement_page *sp = sp_create (upage, writable);
+      if (sp == NULL)
+        return false;
+      if (page_read_bytes > 0)
         {
-          palloc_free_page (kpage);
-          return false; 
+          sp->type = SP_FILE;
+          sp->file = file;
+          sp->offset = ofs;
         }
-      memset (kpage + page_read_bytes, 0, page_zero_bytes);
+      sp->read_bytes = page_read_bytes;
+      sp->zero_bytes = page_zero_bytes;
 
-      /* Add the page to the process's address space. */
-      if (!install_page (upage, kpage, writable)) 
+      /* 이미 다른 segment가 사용 중인 page */
+      if (!sp_insert (&thread_current ()->spt, sp))
         {
-          palloc_free_page (kpage);
-          return false; 
+          free (sp);
+          return false;
         }
-      
-      /* Project 4 */
-      /* 생성한 page의 정보를 supplement page에 저장하고 hash table에 삽입 */
-      struct supplement_page *sp = (struct supplement_page *)malloc(sizeof(struct supplement_page));
-      sp->vaddr = upage;
-      sp->writable = writable;
-      sp_insert(&thread_current ()->spt, sp);
-      /* load된 frame의 정보를 frame에 저장하고, sec_chance_list에 삽입 */
-      struct frame *fr = (struct frame *)malloc(sizeof(struct frame));
-      fr->paddr = kpage;
-      fr->owner = thread_current ();
-      fr->sp = sp;
-      sec_chance_insert(fr);
 
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
       upage += PGSIZE;
     }
 
@@ -537,37 +537,12 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 setup_stack (void **esp) 
 {
-  uint8_t *kpage;
-  bool success = false;
-
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  if(kpage == NULL){
-    /* physical memory 부족한 경우 evict frame */ 
-    evict_frame ();
-    kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  }
+  bool success;
 
-  if (kpage != NULL) 
-    {
-      struct supplement_page *sp = (struct supplement_page *)malloc(sizeof(struct supplement_page));
-      sp->vaddr = ((uint8_t *) PHYS_BASE) - PGSIZE;
-      sp->writable = true;
-      sp_insert(&thread_current ()->spt, sp);
-
-      struct frame *fr = (struct frame *)malloc(sizeof(struct frame));
-      fr->paddr = kpage;
-      fr->owner = thread_current ();
-      fr->sp = sp;
-      sec_chance_insert(fr);
-
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
-      if (success)
-        *esp = PHYS_BASE;
-      else{
-	sec_chance_delete(fr);
-        palloc_free_page (kpage);
-      }
-    }
+  /* stack의 첫 page는 stack_growth()와 같은 방식으로 할당 */
+  success = stack_growth (((uint8_t *) PHYS_BASE) - PGSIZE);
+  if (success)
+    *esp = PHYS_BASE;
 
   return success;
 }
@@ -661,75 +636,94 @@ void construct_stack(void **esp, char** argv, int argc){
   **(uint32_t **)esp = 0;
 }
 
+/* load되지 않은 SP를 physical memory에 load */
 bool handle_mm_fault(struct supplement_page *sp)
 {
-  uint8_t *kpage;
-  bool success = false;
+  size_t slot;
+  bool from_swap, loaded;
+
+  /* 다른 thread가 이 page를 evict하는 중이라면 끝날 때까지 대기
+     eviction이 실패해서 mapping이 복구되었다면 다시 load할 필요 없음 */
+  lock_acquire (&frame_lock);
+  frame_wait (sp);
+  loaded = sp->frame != NULL;
+  lock_release (&frame_lock);
+  if (loaded)
+    return true;
+
+  /* empty frame search (if no empty frame, evict) */
+  uint8_t *kpage = frame_alloc (0, sp);
+  if (kpage == NULL)
+    return false;
 
-  /* empty frame search */
-  kpage = palloc_get_page (PAL_USER);
-  if (kpage == NULL){
-    /* if no empty frame, evict */
-    evict_frame ();
-    kpage = palloc_get_page (PAL_USER);
+  /* empty frame에 page load (swap disk, file 또는 zero page)
+     swap에서 왔는지는 sp_load가 결정 (eviction이 끝난 뒤의 swap_slot 사용) */
+  if (!sp_load (sp, kpage, &slot) || !install_page (sp->vaddr, kpage, sp->writable)){
+    lock_acquire (&frame_lock);
+    frame_free (sp, true);
+    lock_release (&frame_lock);
+    return false;
   }
 
-  if (kpage != NULL){
-    /* empty frame에 page load */
-    success = install_page (pg_round_down(sp->vaddr), kpage, true);
-    if (success){
-      /* disk로 swap_out되었던 page라면, 다시 swap in */
-      if(sp->swap_slot != SIZE_MAX)
-        swap_in(sp->swap_slot, kpage);
-      
-      /* frame 정보 저장 */
-      struct frame *fr = (struct frame *)malloc(sizeof(struct frame));
-      fr->paddr = kpage;
-      fr->owner = thread_current ();
-      fr->sp = sp;
-      sec_chance_insert(fr);
-    }
-    else{
-      palloc_free_page (kpage);
+  /* swap in한 page는 swap slot이 비워지므로, 다시 evict될 때 swap out되도록 dirty 표시 */
+  from_swap = slot != SIZE_MAX;
+  if (from_swap)
+    pagedir_set_dirty (thread_current ()->pagedir, sp->vaddr, true);
+
+  /* load가 끝났으므로 eviction 대상에 포함 */
+  frame_unpin (sp);
+
+  /* 함께 swap out되었던 이웃 page도 미리 swap in */
+  if (from_swap)
+    swap_readahead (slot);
+  return true;
+}
+
+/* swap slot SLOT 바로 뒤의 slot에 있는 현재 process의 page를 최대 SWAP_READAHEAD개 swap in
+   빈 physical frame이 있을 때만 읽고, 이를 위해 eviction하지는 않음 */
+static void swap_readahead (size_t slot)
+{
+  struct thread *cur = thread_current ();
+  struct supplement_page *sps[SWAP_READAHEAD + 1];
+  size_t cnt = swap_neighbors (slot, sps, SWAP_READAHEAD);
+
+  for (size_t i = 0; i < cnt; i++){
+    struct supplement_page *sp = sps[i];
+    uint8_t *kpage = frame_try_alloc (sp);
+    if (kpage == NULL)
+      break;
+
+    /* 실패해도 swap slot이 남아있도록 mapping을 먼저 생성 (load가 끝날 때까지 frame은 pinned) */
+    if (!install_page (sp->vaddr, kpage, sp->writable)){
+      lock_acquire (&frame_lock);
+      frame_free (sp, true);
+      lock_release (&frame_lock);
+      break;
     }
+    sp_load (sp, kpage, NULL);
+    /* 미리 읽은 page는 accessed bit가 0이므로, 사용되지 않으면 먼저 evict됨 */
+    pagedir_set_dirty (cur->pagedir, sp->vaddr, true);
+    frame_unpin (sp);
   }
-
-  return success;
 }
 
 /* stack growth 필요시, 새로운 page 할당해줌 */
 bool stack_growth(void *addr)
 {
-  uint8_t *kpage;
-  bool success = false;
+  /* page 정보 저장 */
+  struct supplement_page *sp = sp_create (addr, true);
+  if (sp == NULL)
+    return false;
+  if (!sp_insert (&thread_current ()->spt, sp)){
+    free (sp);
+    return false;
+  }
 
-  /* empty frame search */
-  kpage = palloc_get_page (PAL_USER);
-  if (kpage == NULL){
-    evict_frame ();
-    kpage = palloc_get_page (PAL_USER);
+  /* 0으로 채워진 page load */
+  if (!handle_mm_fault (sp)){
+    sp_delete (&thread_current ()->spt, sp);
+    free (sp);
+    return false;
   }
-  if (kpage != NULL)
-    {
-      success = install_page (pg_round_down(addr), kpage, true);
-      if (success){
-        /* page 정보 저장 */
-        struct supplement_page *sp = (struct supplement_page *)malloc(sizeof(struct supplement_page));
-        sp->vaddr = pg_round_down(addr);
-        sp->writable = true;
-        sp_insert(&thread_current ()->spt, sp);
-
-        /* frame 정보 저장 */
-        struct frame *fr = (struct frame *)malloc(sizeof(struct frame));
-        fr->paddr = kpage;
-        fr->owner = thread_current ();
-        fr->sp = sp;
-        sec_chance_insert(fr);
-      }
-      else{
-        palloc_free_page (kpage);
-      }
-    }
-  return success;
+  return true;
 }
-
@@ -38,7 +38,6 @@ void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
-  lock_init(&file_read_write);	// file_read_write lock 변수 초기화
 }
 
 static void
@@ -156,8 +155,18 @@ syscall_handler (struct intr_frame *f UNUSED)
 
     /* Project 3 and optionally project 4. */
     case SYS_MMAP:                   /* Map a file into memory. */
+	// syscall 2
+	check_address(f, 2);
+	fd = (int)*(uint32_t *)(f->esp + word);
+	buffer = (void *)*(uint32_t *)(f->esp + word * 2);
+
+	f->eax = mmap(fd, buffer);
 	break;
     case SYS_MUNMAP:                 /* Remove a memory mapping. */
+	// syscall 1
+	check_address(f, 1);
+
+	munmap((mapid_t)*(uint32_t *)(f->esp + word));
 	break;
 
     /* Project 4 only. */
@@ -202,6 +211,53 @@ syscall_handler (struct intr_frame *f UNUSED)
 	check_address(f, 4);
 	f->eax = max_of_four_int((int)*((uint32_t *)(f->esp + word)), (int)*((uint32_t *)(f->esp + word*2)), (int)*((uint32_t *)(f->esp + word*3)), (int)*((uint32_t *)(f->esp + word*4)));
 	break;
+
+    /* Batched directory enumeration */
+    case SYS_GETDENTS:               /* Reads several directory entries. */
+	// syscall 3
+	check_address(f, 3);
+	fd = (int)*(uint32_t *)(f->esp + word);
+	buffer = (void *)*(uint32_t *)(f->esp + word * 2);
+	length = (unsigned)*(uint32_t *)(f->esp + word * 3);
+
+	f->eax = getdents(fd, buffer, length);
+	break;
+
+    /* Positional and vectored I/O */
+    case SYS_PREAD:                  /* Read from a file at a given offset. */
+	// syscall 4
+	check_address(f, 4);
+	fd = (int)*(uint32_t *)(f->esp + word);
+	buffer = (void *)*(uint32_t *)(f->esp + word * 2);
+	length = (unsigned)*(uint32_t *)(f->esp + word * 3);
+
+	f->eax = pread(fd, buffer, length, (unsigned)*(uint32_t *)(f->esp + word * 4));
+	break;
+    case SYS_PWRITE:                 /* Write to a file at a given offset. */
+	// syscall 4
+	check_address(f, 4);
+	fd = (int)*(uint32_t *)(f->esp + word);
+	buffer = (void *)*(uint32_t *)(f->esp + word * 2);
+	length = (unsigned)*(uint32_t *)(f->esp + word * 3);
+
+	f->eax = pwrite(fd, buffer, length, (unsigned)*(uint32_t *)(f->esp + word * 4));
+	break;
+    case SYS_READV:                  /* Read from a file into several buffers. */
+	// syscall 3
+	check_address(f, 3);
+	fd = (int)*(uint32_t *)(f->esp + word);
+	buffer = (void *)*(uint32_t *)(f->esp + word * 2);
+
+	f->eax = readv(fd, buffer, (int)*(uint32_t *)(f->esp + word * 3));
+	break;
+    case SYS_WRITEV:                 /* Write to a file from several buffers. */
+	// syscall 3
+	check_address(f, 3);
+	fd = (int)*(uint32_t *)(f->esp + word);
+	buffer = (void *)*(uint32_t *)(f->esp + word * 2);
+
+	f->eax = writev(fd, buffer, (int)*(uint32_t *)(f->esp + word * 3));
+	break;
   }
 }
 
@@ -307,8 +363,7 @@ int read (int fd, void *buffer, unsigned length){
   if(is_kernel_vaddr(buffer))
     exit(-1);
 
-  lock_acquire(&file_read_write);
-  /* Critical Section */
+  /* file 단위 동기화는 inode의 rw lock에서 처리 */
   if(fd == STDIN_FILENO){
     unsigned read_bytes = 0;
 
@@ -327,8 +382,6 @@ int read (int fd, void *buffer, unsigned length){
     if(cur->file_desc[fd]->f != NULL)
       ret = file_read(cur->file_desc[fd]->f, buffer, length);
   }
-  /* Critical Section */
-  lock_release(&file_read_write);
 
   return ret;
 }
@@ -340,8 +393,7 @@ int write (int fd, const void *buffer, unsigned length)
   if(fd < 0 || fd >= 128)
     exit(-1);
 
-  lock_acquire(&file_read_write);
-  /* Critical Section */
+  /* file 단위 동기화는 inode의 rw lock에서 처리 */
   if(fd == STDOUT_FILENO){    
     putbuf(buffer, length);
     ret = length;
@@ -351,12 +403,94 @@ int write (int fd, const void *buffer, unsigned length)
     if(cur->file_desc[fd]->f != NULL)
       ret = file_write(cur->file_desc[fd]->f, buffer, length);
   }
-  /* Critical Section */
-  lock_release(&file_read_write);
 
   return ret;
 }
 
+/* BUFFER부터 LENGTH byte가 모두 user address space에 있는지 확인 */
+static void check_buffer (const void *buffer, unsigned length){
+  if(is_kernel_vaddr(buffer)
+     || length > (unsigned) (PHYS_BASE - buffer))
+    exit(-1);
+}
+
+int pread (int fd, void *buffer, unsigned length, unsigned offset){
+  int ret = -1;
+
+  if(fd < 0 || fd >= 128)
+    exit(-1);
+
+  check_buffer(buffer, length);
+
+  /* file position을 사용하거나 변경하지 않고 OFFSET부터 read */
+  struct thread *cur = thread_current();
+  if(fd > STDOUT_FILENO && cur->file_desc[fd]->f != NULL)
+    ret = file_read_at(cur->file_desc[fd]->f, buffer, length, offset);
+
+  return ret;
+}
+
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset){
+  int ret = -1;
+
+  if(fd < 0 || fd >= 128)
+    exit(-1);
+
+  check_buffer(buffer, length);
+
+  /* file position을 사용하거나 변경하지 않고 OFFSET부터 write */
+  struct thread *cur = thread_current();
+  if(fd > STDOUT_FILENO && cur->file_desc[fd]->f != NULL && !isdir (fd))
+    ret = file_write_at(cur->file_desc[fd]->f, buffer, length, offset);
+
+  return ret;
+}
+
+/* IOV[0..IOVCNT)와 각 buffer 전체가 user address space에 있는지 확인 */
+static void check_iovec (const struct iovec *iov, int iovcnt){
+  if(iovcnt < 0 || iov == NULL || is_kernel_vaddr(iov)
+     || (unsigned) iovcnt > (PHYS_BASE - (const void *)iov) / sizeof *iov)
+    exit(-1);
+  for(int i=0; i<iovcnt; i++)
+    check_buffer(iov[i].iov_base, iov[i].iov_len);
+}
+
+int readv (int fd, const struct iovec *iov, int iovcnt){
+  int total = 0;
+
+  check_iovec(iov, iovcnt);
+
+  /* buffer 순서대로 read, 짧게 read된 경우 (file 끝) 중단 */
+  for(int i=0; i<iovcnt; i++){
+    int ret = read(fd, iov[i].iov_base, iov[i].iov_len);
+    if(ret < 0)
+      return i == 0 ? ret : total;
+    total += ret;
+    if((unsigned) ret < iov[i].iov_len)
+      break;
+  }
+
+  return total;
+}
+
+int writev (int fd, const struct iovec *iov, int iovcnt){
+  int total = 0;
+
+  check_iovec(iov, iovcnt);
+
+  /* buffer 순서대로 write, 짧게 write된 경우 중단 */
+  for(int i=0; i<iovcnt; i++){
+    int ret = write(fd, iov[i].iov_base, iov[i].iov_len);
+    if(ret < 0)
+      return i == 0 ? ret : total;
+    total += ret;
+    if((unsigned) ret < iov[i].iov_len)
+      break;
+  }
+
+  return total;
+}
+
 void seek (int fd, unsigned position){
   struct thread *cur = thread_current();
 
@@ -387,12 +521,23 @@ void close (int fd){
   dir_close (cur->file_desc[fd]->d);
   cur->file_desc[fd]->d = NULL;	
 }
-/*
+
 mapid_t mmap (int fd, void *addr){
-	return -1;
+  struct thread *cur = thread_current();
+
+  /* STDIN(0), STDOUT(1)과 열려있지 않은 file, directory는 mapping 불가 */
+  if(fd <= 1 || fd >= 128)
+    return MAP_FAILED;
+  if(cur->file_desc[fd]->f == NULL || isdir (fd))
+    return MAP_FAILED;
+
+  return mmap_map(cur->file_desc[fd]->f, addr);
+}
+
+void munmap (mapid_t mapid){
+  mmap_unmap(mapid);
 }
-void munmap (mapid_t){
-} */
+
 bool chdir (const char *dir){
   struct dir *directory = open_directory_path (dir);
 
@@ -420,6 +565,22 @@ bool readdir (int fd, char* name){
   return false;
 }
 
+int getdents (int fd, struct dirent *ents, unsigned cnt){
+  if(fd < 0 || fd >= 128)
+    exit(-1);
+
+  /* user buffer 전체가 user address space에 있어야 함 */
+  if(ents == NULL || is_kernel_vaddr(ents)
+     || cnt > (PHYS_BASE - (void *)ents) / sizeof *ents)
+    exit(-1);
+
+  /* directory인 경우, 한 번의 system call로 가능한 만큼 directory entry read */
+  if (isdir (fd))
+    return dir_readdir_batch (thread_current ()->file_desc[fd]->d, ents, cnt);
+
+  return -1;
+}
+
 bool isdir (int fd){
   struct file *file = thread_current ()->file_desc[fd]->f;
   /* 해당 fd file이 directory인지 여부 return */ 
@@ -2,8 +2,16 @@
 #define USERPROG_SYSCALL_H
 #include "threads/thread.h"
 #include "threads/interrupt.h"
+#include "filesys/directory.h"
+#include "vm/page.h"
 
-struct lock file_read_write;
+/* readv(), writev()의 buffer
+   lib/user/syscall.h의 `struct iovec'과 같은 layout */
+struct iovec
+  {
+    void *iov_base;                     /* Start of buffer. */
+    unsigned iov_len;                   /* Size of buffer in bytes. */
+  };
 
 void syscall_init (void);
 /* invalid pointer check */
@@ -23,14 +31,20 @@ void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
 /* Project 3 */
-//mapid_t mmap (int fd, void *addr);
-//void munmap (mapid_t);
+mapid_t mmap (int fd, void *addr);
+void munmap (mapid_t mapid);
 /* Project 4 */
 bool chdir (const char *dir);
 bool mkdir (const char *dir);
 bool readdir (int fd, char* name);
 bool isdir (int fd);
 int inumber (int fd);
+int getdents (int fd, struct dirent *ents, unsigned cnt);
+/* Positional and vectored I/O */
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
 /* Project 2 additional */
 int fibonacci (int n);
 int max_of_four_int (int a, int b, int c, int d);
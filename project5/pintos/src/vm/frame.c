@@ -1,12 +1,20 @@
 #include <list.h>
+#include "threads/malloc.h"
+#include "filesys/file.h"
 #include "vm/page.h"
 #include "vm/frame.h"
 #include "vm/swap.h"
 #include "userprog/pagedir.h"
 
+static struct condition evict_done;	// eviction이 끝날 때마다 broadcast (frame_lock과 함께 사용)
+static size_t evicting_cnt;		// evict 중인 (I/O 중인) frame 수
+
 void sec_chance_init (void)
 {
   list_init(&sec_chance_list);
+  lock_init(&frame_lock);
+  cond_init(&evict_done);
+  evicting_cnt = 0;
   check_frame = NULL; 
 }
 
@@ -43,30 +51,211 @@ struct list_elem *next_frame (void)
   return list_next(check_frame);
 }
 
-/* second chance algoritm을 통해 frame eviction */
-void evict_frame (void)
+/* second chance algoritm을 통해 최대 EVICT_BATCH개의 frame eviction
+   수정된 anonymous page는 연속된 swap slot에 한 번에 swap out
+   frame_lock을 획득한 상태에서 호출, evict한 frame이 없으면 false return
+   file write와 swap out 동안에는 frame_lock을 놓으므로, 다른 thread의 fault가 I/O를 기다리지 않음 */
+bool evict_frame (void)
 {
-  struct frame *victim = NULL;
+  struct frame *victims[EVICT_BATCH];
+  struct frame *swap_victims[EVICT_BATCH];
+  bool dirty[EVICT_BATCH];
+  size_t victim_cnt = 0, swap_cnt = 0, swapped, freed = 0;
+  /* 모든 frame이 pinned인 경우 무한히 돌지 않도록 list를 최대 두 바퀴만 탐색 */
+  size_t cnt = 2 * list_size(&sec_chance_list);
   check_frame = next_frame ();
 
-  while(check_frame){
-    victim = list_entry(check_frame, struct frame, elem);
-    /* accessed bit가 0이라면, 해당 frame evict */
-    if(!(victim->sp->vaddr >= 0x8040000 &&victim->sp->vaddr <= 0x8060000) && !pagedir_is_accessed(victim->owner->pagedir, victim->sp->vaddr))
-      break;
-    /* accessed bit가 1이라면, accessed bit 0으로 변경 후 다음 frame check */
-    pagedir_set_accessed(victim->owner->pagedir, victim->sp->vaddr, false);
+  while(check_frame && cnt-- > 0 && victim_cnt < EVICT_BATCH){
+    struct frame *f = list_entry(check_frame, struct frame, elem);
+    if(!f->pinned){
+      /* accessed bit가 0이라면, 해당 frame evict
+         I/O 중에 다른 thread가 evict하거나 free하지 않도록 pinned로 표시 */
+      if(!(f->sp->vaddr >= 0x8040000 && f->sp->vaddr <= 0x8060000) && !pagedir_is_accessed(f->owner->pagedir, f->sp->vaddr)){
+        f->pinned = true;
+        f->evicting = true;
+        evicting_cnt++;
+        victims[victim_cnt++] = f;
+      }
+      /* accessed bit가 1이라면, accessed bit 0으로 변경 후 다음 frame check */
+      else
+        pagedir_set_accessed(f->owner->pagedir, f->sp->vaddr, false);
+    }
     check_frame = next_frame ();
   }
 
-  if(victim == NULL)
-    return;
+  /* 다른 thread가 evict 중인 frame밖에 없다면, 그 eviction이 끝난 뒤 다시 시도 */
+  if(victim_cnt == 0){
+    if(evicting_cnt == 0)
+      return false;
+    cond_wait(&evict_done, &frame_lock);
+    return true;
+  }
+
+  for(size_t i=0; i<victim_cnt; i++){
+    struct frame *victim = victims[i];
+    struct supplement_page *sp = victim->sp;
+    /* 먼저 mapping을 끊어 owner가 evict 중인 page에 쓰지 못하도록 함
+       (not present로 바뀌어도 dirty bit는 남아있음) */
+    pagedir_clear_page(victim->owner->pagedir, sp->vaddr);
+    dirty[i] = pagedir_is_dirty(victim->owner->pagedir, sp->vaddr);
+    /* 수정된 page만 swap out, 한 번에 write하기 위해 모아둠 */
+    if(sp->type != SP_MMAP && dirty[i])
+      swap_victims[swap_cnt++] = victim;
+  }
+
+  /* victim은 pinned이고 owner의 fault, munmap, exit은 eviction이 끝날 때까지 기다리므로
+     frame_lock 없이 victim의 page를 읽을 수 있음 */
+  lock_release(&frame_lock);
+
+  /* mmap page는 수정된 경우에만 file에 write back */
+  for(size_t i=0; i<victim_cnt; i++){
+    struct supplement_page *sp = victims[i]->sp;
+    if(sp->type == SP_MMAP && dirty[i])
+      file_write_at(sp->file, victims[i]->paddr, sp->read_bytes, sp->offset);
+  }
+  /* 이후로는 swap disk가 page의 backing store */
+  swapped = swap_out(swap_victims, swap_cnt);
+
+  lock_acquire(&frame_lock);
+
+  for(size_t i=0; i<victim_cnt; i++){
+    victims[i]->evicting = false;
+    evicting_cnt--;
+    /* 수정되지 않은 page는 executable file 또는 0으로 다시 load할 수 있으므로 그냥 버림
+       victim frame을 physical memory로부터 제거 */
+    if(victims[i]->sp->type == SP_MMAP || !dirty[i]){
+      frame_free(victims[i]->sp, true);
+      freed++;
+    }
+  }
+
+  for(size_t i=0; i<swap_cnt; i++){
+    struct frame *victim = swap_victims[i];
+    struct supplement_page *sp = victim->sp;
+
+    if(i < swapped){
+      sp->type = SP_ANON;
+      sp->file = NULL;
+      frame_free(sp, true);
+      freed++;
+    }
+    /* swap disk가 가득 찬 경우, mapping을 되돌림 */
+    else{
+      pagedir_set_page(victim->owner->pagedir, sp->vaddr, victim->paddr, sp->writable);
+      pagedir_set_dirty(victim->owner->pagedir, sp->vaddr, true);
+      victim->pinned = false;
+    }
+  }
+
+  /* eviction이 끝나길 기다리는 thread (fault, munmap, exit) 깨우기 */
+  cond_broadcast(&evict_done, &frame_lock);
+  return freed > 0;
+}
+
+/* SP의 frame이 evict 중이라면 eviction이 끝날 때까지 대기
+   return 후 SP의 frame이 NULL이 아니라면 eviction이 실패해서 mapping이 복구된 것
+   frame_lock을 획득한 상태에서 호출 */
+void frame_wait (struct supplement_page *sp)
+{
+  while(sp->frame != NULL && sp->frame->evicting)
+    cond_wait(&evict_done, &frame_lock);
+}
+
+/* owner가 T인 frame의 eviction이 모두 끝날 때까지 대기 (process 종료 시)
+   frame_lock을 획득한 상태에서 호출 */
+void frame_wait_owner (struct thread *t)
+{
+  struct list_elem *e = list_begin(&sec_chance_list);
+
+  while(e != list_end(&sec_chance_list)){
+    struct frame *f = list_entry(e, struct frame, elem);
+    if(f->owner == t && f->evicting){
+      /* 기다리는 동안 list가 바뀔 수 있으므로 처음부터 다시 확인 */
+      cond_wait(&evict_done, &frame_lock);
+      e = list_begin(&sec_chance_list);
+    }
+    else
+      e = list_next(e);
+  }
+}
+
+/* SP를 위한 frame 생성, frame_lock을 획득한 상태에서 호출 */
+static void frame_init (struct frame *f, void *kpage, struct supplement_page *sp)
+{
+  f->paddr = kpage;
+  f->sp = sp;
+  f->owner = thread_current ();
+  f->pinned = true;
+  f->evicting = false;
+  sec_chance_insert(f);
+  sp->frame = f;
+}
+
+/* SP를 위한 physical frame 할당, 부족하면 eviction 후 재시도
+   load가 끝날 때까지 evict되지 않도록 pinned 상태로 return
+   evict할 수 있는 frame이 없으면 (모두 pinned이거나 swap disk가 가득 참) NULL return */
+void *frame_alloc (enum palloc_flags flags, struct supplement_page *sp)
+{
+  struct frame *f = malloc(sizeof *f);
+  void *kpage;
+
+  if(f == NULL)
+    return NULL;
+
+  lock_acquire(&frame_lock);
+  while((kpage = palloc_get_page(PAL_USER | flags)) == NULL)
+    if(!evict_frame()){
+      lock_release(&frame_lock);
+      free(f);
+      return NULL;
+    }
+
+  frame_init(f, kpage, sp);
+  lock_release(&frame_lock);
+
+  return kpage;
+}
+
+/* frame_alloc()과 같지만, 빈 physical frame이 없으면 eviction하지 않고 NULL return
+   swap in 할 때 이웃 page를 미리 읽는 경우처럼 반드시 필요하지 않은 할당에 사용 */
+void *frame_try_alloc (struct supplement_page *sp)
+{
+  struct frame *f = malloc(sizeof *f);
+  void *kpage;
+
+  if(f == NULL)
+    return NULL;
+
+  lock_acquire(&frame_lock);
+  /* 아직 evict 중인 page는 eviction이 끝난 뒤에 읽어야 하므로 건너뜀 */
+  kpage = sp->frame == NULL ? palloc_get_page(PAL_USER) : NULL;
+  if(kpage != NULL)
+    frame_init(f, kpage, sp);
+  lock_release(&frame_lock);
+
+  if(kpage == NULL)
+    free(f);
+  return kpage;
+}
+
+/* load가 끝난 SP의 frame을 eviction 대상에 포함 */
+void frame_unpin (struct supplement_page *sp)
+{
+  lock_acquire(&frame_lock);
+  if(sp->frame != NULL)
+    sp->frame->pinned = false;
+  lock_release(&frame_lock);
+}
+
+/* SP의 frame을 list에서 제거, FREE_PAGE가 true면 physical page도 free
+   frame_lock을 획득한 상태에서 호출 */
+void frame_free (struct supplement_page *sp, bool free_page)
+{
+  struct frame *f = sp->frame;
 
-  /* victim page swap out */
-  victim->sp->swap_slot = swap_out(victim->paddr);
-  /* victim frame을 physical memory로부터 제거 */
-  sec_chance_delete(victim);
-  pagedir_clear_page(victim->owner->pagedir, victim->sp->vaddr);
-  palloc_free_page(victim->paddr);
-  free(victim);
+  sec_chance_delete(f);
+  if(free_page)
+    palloc_free_page(f->paddr);
+  sp->frame = NULL;
+  free(f);
 }
@@ -6,14 +6,23 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
+
+struct supplement_page;
+
+/* 한 번의 eviction에서 evict하는 최대 frame 수 */
+#define EVICT_BATCH 8
 
 struct list sec_chance_list;
 struct list_elem *check_frame;
+struct lock frame_lock;		// sec_chance_list, frame, supplement page의 frame/swap 정보 보호
 
 struct frame {
   void *paddr;			// physical address
   struct supplement_page *sp;	// 해당 frame에 mapping된 page
   struct thread *owner;		// page의 owner
+  bool pinned;			// load 중인 frame은 evict하지 않음
+  bool evicting;		// eviction I/O 중 (frame_lock 없이 write 중)
   struct list_elem elem;	// sec_chance list에서 탐색을 위한 list_elem
 };
 
@@ -21,6 +30,13 @@ void sec_chance_init (void);
 void sec_chance_insert (struct frame *f);
 void sec_chance_delete (struct frame *f);
 struct list_elem *next_frame (void);
-void evict_frame (void);
+bool evict_frame (void);
+void frame_wait (struct supplement_page *sp);
+void frame_wait_owner (struct thread *t);
+
+void *frame_alloc (enum palloc_flags flags, struct supplement_page *sp);
+void *frame_try_alloc (struct supplement_page *sp);
+void frame_unpin (struct supplement_page *sp);
+void frame_free (struct supplement_page *sp, bool free_page);
 
 #endif
@@ -1,5 +1,12 @@
 #include "vm/page.h"
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
 #include "threads/vaddr.h"
+#include "filesys/file.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
 
 static unsigned spt_hash_func (const struct hash_elem *e,void *aux)
 {
@@ -17,9 +24,18 @@ static bool spt_less_func (const struct hash_elem *a, const struct hash_elem *b,
   return spa->vaddr < spb->vaddr;
 }
 
+/* process 종료 시 supplement page 정리
+   load된 frame은 list에서만 제거 (physical page는 pagedir_destroy()에서 free)
+   swap out된 page는 swap slot free */
 static void spt_destruct_func (struct hash_elem *e, void *aux)
 {
+  struct supplement_page *sp = hash_entry(e, struct supplement_page, elem);
 
+  if(sp->frame != NULL)
+    frame_free(sp, false);
+  if(sp->swap_slot != SIZE_MAX)
+    swap_free(sp->swap_slot);
+  free(sp);
 }
 
 void sp_init (struct hash *spt)
@@ -27,9 +43,27 @@ void sp_init (struct hash *spt)
   hash_init(spt, spt_hash_func, spt_less_func, NULL);
 }
 
+/* VADDR page의 supplement page 생성 (anonymous, load되지 않은 상태) */
+struct supplement_page *sp_create (void *vaddr, bool writable)
+{
+  struct supplement_page *sp = (struct supplement_page *)malloc(sizeof(struct supplement_page));
+  if(sp == NULL)
+    return NULL;
+
+  sp->vaddr = pg_round_down(vaddr);
+  sp->writable = writable;
+  sp->type = SP_ANON;
+  sp->swap_slot = SIZE_MAX;
+  sp->frame = NULL;
+  sp->file = NULL;
+  sp->offset = 0;
+  sp->read_bytes = 0;
+  sp->zero_bytes = PGSIZE;
+  return sp;
+}
+
 bool sp_insert (struct hash *spt, struct supplement_page *sp)
 {  
-  sp->swap_slot = SIZE_MAX;
   if(hash_insert(spt, &sp->elem) == NULL)
     return true;
   return false;
@@ -55,7 +89,145 @@ struct supplement_page *sp_find (void *vaddr)
   return hash_entry(e, struct supplement_page, elem);
 }
 
+/* SP의 내용을 KPAGE에 load
+   swap out된 page는 swap disk에서, file page는 file에서 read하고, 나머지는 0으로 채움
+   swap disk에서 읽은 경우 그 slot 번호를, 아니면 SIZE_MAX를 SLOT에 저장 (SLOT이 NULL이면 무시)
+   같은 page의 eviction이 끝나고 새 frame을 받은 뒤에 호출되므로 최종 swap_slot을 보게 됨 */
+bool sp_load (struct supplement_page *sp, void *kpage, size_t *slot)
+{
+  if(slot != NULL)
+    *slot = sp->swap_slot;
+
+  if(sp->swap_slot != SIZE_MAX){
+    swap_in(sp->swap_slot, kpage);
+    sp->swap_slot = SIZE_MAX;
+    return true;
+  }
+
+  if(sp->file != NULL){
+    if(file_read_at(sp->file, kpage, sp->read_bytes, sp->offset) != (off_t) sp->read_bytes)
+      return false;
+    memset((uint8_t *) kpage + sp->read_bytes, 0, PGSIZE - sp->read_bytes);
+    return true;
+  }
+
+  memset(kpage, 0, PGSIZE);
+  return true;
+}
+
 void sp_destroy (struct hash *spt)
 {
+  lock_acquire(&frame_lock);
+  /* 다른 thread가 evict 중인 frame은 I/O가 끝난 뒤 free */
+  frame_wait_owner(thread_current ());
+  hash_destroy(spt, spt_destruct_func);
+  lock_release(&frame_lock);
+}
+
+/* FILE을 ADDR부터 mapping하고 mapid return, 실패 시 MAP_FAILED
+   page는 처음 접근할 때 file에서 load (demand paging) */
+mapid_t mmap_map (struct file *file, void *addr)
+{
+  struct thread *cur = thread_current ();
+  off_t length = file_length(file);
+  size_t page_cnt = DIV_ROUND_UP(length, PGSIZE);
+  struct mmap_file *mf;
+
+  /* 빈 file, 정렬되지 않은 주소, 0번 page, kernel 영역과 겹치는 mapping 불가 */
+  if(length == 0 || addr == NULL || pg_ofs(addr) != 0
+     || !is_user_vaddr((uint8_t *) addr + page_cnt * PGSIZE - 1))
+    return MAP_FAILED;
+  /* 이미 사용 중인 page (code, data, stack, 다른 mapping)와 겹치는 mapping 불가 */
+  for(size_t i=0; i<page_cnt; i++){
+    void *upage = (uint8_t *) addr + i * PGSIZE;
+    if(sp_find(upage) != NULL || pagedir_get_page(cur->pagedir, upage) != NULL)
+      return MAP_FAILED;
+  }
+
+  mf = malloc(sizeof *mf);
+  if(mf == NULL)
+    return MAP_FAILED;
+  /* 원래 file이 close되어도 mapping은 유지되도록 reopen */
+  mf->file = file_reopen(file);
+  if(mf->file == NULL){
+    free(mf);
+    return MAP_FAILED;
+  }
+  mf->mapid = cur->mapid_cnt++;
+  mf->addr = addr;
+  mf->page_cnt = 0;
+  list_push_back(&cur->mmap_list, &mf->elem);
+
+  for(size_t i=0; i<page_cnt; i++){
+    off_t ofs = i * PGSIZE;
+    struct supplement_page *sp = sp_create((uint8_t *) addr + ofs, true);
+    if(sp == NULL){
+      mmap_unmap(mf->mapid);
+      return MAP_FAILED;
+    }
+    sp->type = SP_MMAP;
+    sp->file = mf->file;
+    sp->offset = ofs;
+    sp->read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+    sp->zero_bytes = PGSIZE - sp->read_bytes;
+    sp_insert(&cur->spt, sp);
+    mf->page_cnt++;
+  }
+
+  return mf->mapid;
+}
+
+/* MAPID mapping 해제
+   load되어 있는 page 중 수정된 page는 file에 write back */
+void mmap_unmap (mapid_t mapid)
+{
+  struct thread *cur = thread_current ();
+  struct mmap_file *mf = NULL;
+  struct list_elem *e;
+
+  for(e = list_begin(&cur->mmap_list); e != list_end(&cur->mmap_list); e = list_next(e))
+    if(list_entry(e, struct mmap_file, elem)->mapid == mapid){
+      mf = list_entry(e, struct mmap_file, elem);
+      break;
+    }
+  if(mf == NULL)
+    return;
+
+  for(size_t i=0; i<mf->page_cnt; i++){
+    struct supplement_page *sp = sp_find((uint8_t *) mf->addr + i * PGSIZE);
+    if(sp == NULL)
+      continue;
+
+    lock_acquire(&frame_lock);
+    frame_wait(sp);
+    if(sp->frame != NULL){
+      /* mapping을 끊고 write back 동안 evict되지 않도록 pin
+         file write는 frame_lock을 놓고 수행 */
+      sp->frame->pinned = true;
+      pagedir_clear_page(cur->pagedir, sp->vaddr);
+      if(pagedir_is_dirty(cur->pagedir, sp->vaddr)){
+        lock_release(&frame_lock);
+        file_write_at(sp->file, sp->frame->paddr, sp->read_bytes, sp->offset);
+        lock_acquire(&frame_lock);
+      }
+      frame_free(sp, true);
+    }
+    lock_release(&frame_lock);
+
+    sp_delete(&cur->spt, sp);
+    free(sp);
+  }
+
+  list_remove(&mf->elem);
+  file_close(mf->file);
+  free(mf);
+}
+
+/* process의 모든 mapping 해제 (process 종료 시) */
+void mmap_unmap_all (void)
+{
+  struct thread *cur = thread_current ();
 
+  while(!list_empty(&cur->mmap_list))
+    mmap_unmap(list_entry(list_front(&cur->mmap_list), struct mmap_file, elem)->mapid);
 }
@@ -5,19 +5,55 @@
 #include <list.h>
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "filesys/off_t.h"
+
+/* Map region identifier. */
+typedef int mapid_t;
+#define MAP_FAILED ((mapid_t) -1)
+
+/* page의 backing store 종류 */
+enum sp_type {
+  SP_ANON,		// swap disk (stack 등)
+  SP_FILE,		// executable file, 수정된 page는 swap out 후 SP_ANON이 됨
+  SP_MMAP		// memory mapped file, dirty page는 file에 write back
+};
 
 /* page fault handling을 위한 supplement page */
 struct supplement_page {
   void *vaddr; 		// page의 virtual address
   bool writable;	// writable 여부
+  enum sp_type type;	// backing store 종류
   struct hash_elem elem;// supplement page는 hash를 통해 관리
   size_t swap_slot;	// disk swap을 위한 swap index
+  struct frame *frame;	// page가 load된 frame, load되지 않았으면 NULL
+
+  /* file에서 load하는 page (file이 NULL이 아닌 경우)
+     file의 offset부터 read_bytes를 read하고 나머지 zero_bytes는 0으로 채움 */
+  struct file *file;
+  off_t offset;
+  size_t read_bytes;
+  size_t zero_bytes;
+};
+
+/* mmap()으로 mapping된 file */
+struct mmap_file {
+  mapid_t mapid;
+  struct file *file;	// mmap 시 reopen한 file
+  void *addr;		// mapping 시작 주소
+  size_t page_cnt;	// mapping된 page 수
+  struct list_elem elem;// thread의 mmap_list element
 };
 
 void sp_init (struct hash *spt);
+struct supplement_page *sp_create (void *vaddr, bool writable);
 bool sp_insert (struct hash *spt, struct supplement_page *sp);
 bool sp_delete (struct hash *spt, struct supplement_page *sp);
 struct supplement_page *sp_find (void *vaddr);
+bool sp_load (struct supplement_page *sp, void *kpage, size_t *slot);
 void sp_destroy (struct hash *spt);
 
+mapid_t mmap_map (struct file *file, void *addr);
+void mmap_unmap (mapid_t mapid);
+void mmap_unmap_all (void);
+
 #endif
@@ -1,18 +1,43 @@
 #include "vm/swap.h"
+#include <bitmap.h>
 #include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
 #include "vm/frame.h"
 #include "vm/page.h"
-#include "vm/swap.h"
 
 #define blocks (PGSIZE / BLOCK_SECTOR_SIZE)
-#define swap_table_size 1024
+
+/* swap slot에 저장된 page, swap in 할 때 같이 읽을 이웃 page를 찾기 위해 사용 */
+struct swap_slot {
+  struct supplement_page *sp;
+  struct thread *owner;
+};
+
+static struct block *swap_disk;
+static struct bitmap *swap_table;	// swap slot 사용 여부, slot 하나당 1 bit
+static struct lock swap_lock;		// swap_table, swap_hint 보호
+static size_t swap_hint;		// 다음 빈 slot 탐색을 시작할 위치
+static struct swap_slot *swap_slots;	// slot별 page 정보
+
+static size_t swap_alloc(size_t cnt);
+static void swap_write(size_t idx, struct frame *f);
 
 void swap_init (void)
 {
+  /* swap disk 크기에 맞춰 swap table 생성 (swap disk가 없으면 slot 0개) */
+  size_t slot_cnt = 0;
+
   swap_disk = block_get_role(BLOCK_SWAP);
-  swap_table = (int *)malloc(sizeof(int) * swap_table_size);
-  for(int i=0; i<swap_table_size; i++)
-    swap_table[i] = -1;
+  if(swap_disk != NULL)
+    slot_cnt = block_size(swap_disk) / blocks;
+  swap_table = bitmap_create(slot_cnt);
+  swap_slots = calloc(slot_cnt, sizeof *swap_slots);
+  if(swap_table == NULL || (slot_cnt > 0 && swap_slots == NULL))
+    PANIC("swap table creation failed");
+  lock_init(&swap_lock);
+  swap_hint = 0;
 }
 
 void swap_in(size_t idx, void *paddr)
@@ -21,27 +46,89 @@ void swap_in(size_t idx, void *paddr)
   for(int i=0; i<blocks; i++)
     block_read(swap_disk, blocks * idx + i, BLOCK_SECTOR_SIZE * i + paddr);
   /* swap_slot 비우기 */
-  swap_table[idx] = -1;
+  swap_free(idx);
+}
+
+/* CNT개의 연속된 빈 swap slot을 할당하고 첫 slot return
+   hint부터 탐색하고, 없으면 처음부터 다시 탐색, 그래도 없으면 BITMAP_ERROR */
+static size_t swap_alloc(size_t cnt)
+{
+  size_t swap_idx;
+
+  lock_acquire(&swap_lock);
+  swap_idx = bitmap_scan_and_flip(swap_table, swap_hint, cnt, false);
+  if(swap_idx == BITMAP_ERROR && swap_hint != 0)
+    swap_idx = bitmap_scan_and_flip(swap_table, 0, cnt, false);
+  if(swap_idx != BITMAP_ERROR)
+    swap_hint = (swap_idx + cnt) % bitmap_size(swap_table);
+  lock_release(&swap_lock);
+
+  return swap_idx;
 }
 
-size_t swap_out(void *paddr)
+/* frame F의 page를 swap slot IDX에 write */
+static void swap_write(size_t idx, struct frame *f)
 {
-  size_t swap_idx = SIZE_MAX;
-  /* swap table의 비어있는 swap slot 탐색 */
-  for(int i=0; i<swap_table_size; i++) {
-    /* 비어있는 swap slot 찾은 경우 */
-    if(swap_table[i] == -1) {
-      swap_idx = i;
-      /* write page to swap disk */
-      for(int j=0; j<blocks; j++)
-        block_write(swap_disk, blocks * swap_idx + j, BLOCK_SECTOR_SIZE * j + paddr);
-
-      /* swap slot 채우기 */
-      swap_table[i] = 1;
+  /* write page to swap disk */
+  for(int j=0; j<blocks; j++)
+    block_write(swap_disk, blocks * idx + j, BLOCK_SECTOR_SIZE * j + f->paddr);
 
+  f->sp->swap_slot = idx;
+  lock_acquire(&swap_lock);
+  swap_slots[idx].sp = f->sp;
+  swap_slots[idx].owner = f->owner;
+  lock_release(&swap_lock);
+}
+
+/* FRAMES[]의 CNT개 page를 swap out
+   가능하면 연속된 slot에 할당해서 disk에 한 번에 순서대로 write
+   연속된 slot이 없으면 한 page씩 빈 slot에 write
+   swap out된 page 수 return (swap disk가 가득 차면 CNT보다 작음) */
+size_t swap_out(struct frame **frames, size_t cnt)
+{
+  size_t swap_idx = cnt > 1 ? swap_alloc(cnt) : BITMAP_ERROR;
+  size_t done;
+
+  if(swap_idx != BITMAP_ERROR){
+    for(done=0; done<cnt; done++)
+      swap_write(swap_idx + done, frames[done]);
+    return done;
+  }
+
+  for(done=0; done<cnt; done++){
+    swap_idx = swap_alloc(1);
+    /* swap disk가 가득 찬 경우 */
+    if(swap_idx == BITMAP_ERROR)
       break;
-    }
+    swap_write(swap_idx, frames[done]);
   }
+  return done;
+}
 
-  return swap_idx;
+/* swap slot IDX 바로 뒤의 slot 중, 현재 process의 page를 최대 MAX개 SPS[]에 저장하고 개수 return
+   함께 swap out된 page는 같이 사용될 가능성이 높으므로 swap in 할 때 미리 읽음 */
+size_t swap_neighbors(size_t idx, struct supplement_page **sps, size_t max)
+{
+  struct thread *cur = thread_current ();
+  size_t cnt = 0;
+
+  lock_acquire(&swap_lock);
+  for(size_t i = idx + 1; cnt < max && i < bitmap_size(swap_table); i++){
+    if(!bitmap_test(swap_table, i) || swap_slots[i].owner != cur)
+      break;
+    sps[cnt++] = swap_slots[i].sp;
+  }
+  lock_release(&swap_lock);
+
+  return cnt;
+}
+
+/* 더 이상 사용하지 않는 swap slot 비우기 */
+void swap_free(size_t idx)
+{
+  lock_acquire(&swap_lock);
+  bitmap_reset(swap_table, idx);
+  swap_slots[idx].sp = NULL;
+  swap_slots[idx].owner = NULL;
+  lock_release(&swap_lock);
 }
@@ -1,14 +1,19 @@
 #ifndef VM_SWAP_H
 #define VM_SWAP_H
 
-#include <hash.h>
-#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
 
-struct block *swap_disk;
-int *swap_table;
+/* swap in 할 때 함께 읽을 이웃 page의 최대 수 (0이면 사용하지 않음) */
+#define SWAP_READAHEAD 4
+
+struct frame;
+struct supplement_page;
 
 void swap_init(void);
 void swap_in(size_t idx, void *paddr);
-size_t swap_out(void *paddr);
+size_t swap_out(struct frame **frames, size_t cnt);
+size_t swap_neighbors(size_t idx, struct supplement_page **sps, size_t max);
+void swap_free(size_t idx);
 
 #endif